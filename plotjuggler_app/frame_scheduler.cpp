@@ -0,0 +1,142 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+FrameScheduler::FrameScheduler(int min_interval_ms, QObject* parent)
+  : QObject(parent), _min_interval(min_interval_ms), _interval(min_interval_ms)
+{
+  _timer = new QTimer(this);
+  _timer->setSingleShot(true);
+  _timer->setTimerType(Qt::PreciseTimer);
+  connect(_timer, &QTimer::timeout, this, &FrameScheduler::onTimeout);
+  _clock.start();
+}
+
+void FrameScheduler::requestFrame()
+{
+  if (_in_frame)
+  {
+    _pending = true;
+  }
+  else if (!_timer->isActive())
+  {
+    scheduleNext();
+  }
+}
+
+void FrameScheduler::setContinuous(bool enable)
+{
+  if (!enable)
+  {
+    stop();
+    return;
+  }
+  _continuous = true;
+  requestFrame();
+}
+
+void FrameScheduler::stop()
+{
+  _timer->stop();
+  _continuous = false;
+  _pending = false;
+  _phase_nsecs.fill(0);
+  _lod_cooldown = 0;
+  setLevelOfDetail(1.0);
+}
+
+void FrameScheduler::endPhase(Phase phase)
+{
+  if (!_in_frame)
+  {
+    return;
+  }
+  const qint64 now = _clock.nsecsElapsed();
+  _phase_nsecs[phase] += now - _phase_start;
+  _phase_start = now;
+}
+
+void FrameScheduler::addTime(Phase phase, qint64 nsecs)
+{
+  _phase_nsecs[phase] += nsecs;
+}
+
+void FrameScheduler::onTimeout()
+{
+  _pending = false;
+  _in_frame = true;
+  _frame_start = _clock.nsecsElapsed();
+  _phase_start = _frame_start;
+
+  emit frameTriggered();
+
+  // whatever was not assigned to a phase is considered rendering
+  endPhase(RENDER);
+  _in_frame = false;
+  _last_duration = _clock.nsecsElapsed() - _frame_start;
+
+  updateEstimate();
+
+  if (_continuous || _pending)
+  {
+    scheduleNext();
+  }
+}
+
+void FrameScheduler::scheduleNext()
+{
+  const qint64 since_start_ms = (_clock.nsecsElapsed() - _frame_start) / 1000000;
+  // leave the GUI thread idle at least as long as the previous frame took
+  // (painting, user input), even if the interval is already elapsed.
+  const qint64 delay =
+      std::max(qint64(_interval) - since_start_ms, _last_duration / 1000000);
+  _timer->start(int(std::clamp<qint64>(delay, 0, MAX_INTERVAL_MS)));
+}
+
+void FrameScheduler::updateEstimate()
+{
+  const qint64 nsecs = std::accumulate(_phase_nsecs.begin(), _phase_nsecs.end(), 0LL);
+  _phase_nsecs.fill(0);
+
+  // react quickly to an overload, but slowly to an improvement, to avoid
+  // oscillations of the refresh rate.
+  const double cost_ms = double(nsecs) * 1e-6;
+  const double alpha = (cost_ms > _cost_ms) ? 0.5 : 0.1;
+  _cost_ms += alpha * (cost_ms - _cost_ms);
+
+  const double needed_interval = _cost_ms / MAX_LOAD;
+  _interval = std::clamp(int(std::ceil(needed_interval)), _min_interval,
+                         int(MAX_INTERVAL_MS));
+
+  if (_lod_cooldown > 0)
+  {
+    _lod_cooldown--;
+    return;
+  }
+  if (needed_interval > DEGRADE_INTERVAL_MS && _level_of_detail > MIN_LEVEL_OF_DETAIL)
+  {
+    setLevelOfDetail(std::max(MIN_LEVEL_OF_DETAIL, _level_of_detail * 0.5));
+    _lod_cooldown = LOD_COOLDOWN_FRAMES;
+  }
+  else if (needed_interval < RESTORE_INTERVAL_MS && _level_of_detail < 1.0)
+  {
+    setLevelOfDetail(std::min(1.0, _level_of_detail * 2.0));
+    _lod_cooldown = LOD_COOLDOWN_FRAMES;
+  }
+}
+
+void FrameScheduler::setLevelOfDetail(double lod)
+{
+  if (lod != _level_of_detail)
+  {
+    _level_of_detail = lod;
+    emit levelOfDetailChanged(lod);
+  }
+}
@@ -0,0 +1,122 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <array>
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+/**
+ * @brief Decides when the next frame (update of the data and replot) is emitted.
+ *
+ * The duration of each frame is measured, split in phases (merge of the new
+ * data, transforms, render). The interval between two frames is adapted to keep
+ * the time spent in frames below MAX_LOAD of the time of the GUI thread: on a slow
+ * machine, or with a lot of data, the plots are refreshed less often, but the UI
+ * remains responsive.
+ *
+ * All the requests received before the next frame are coalesced into one.
+ * When even the longest interval is not enough, the level of detail of the
+ * curves is reduced (see PlotWidgetBase::setLevelOfDetail()).
+ */
+class FrameScheduler : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum Phase
+  {
+    MERGE = 0,
+    TRANSFORM,
+    RENDER,
+    PHASES_COUNT
+  };
+
+  enum
+  {
+    MAX_INTERVAL_MS = 500,
+    // the level of detail is reduced if the frames can't be refreshed at this rate
+    DEGRADE_INTERVAL_MS = 100,
+    RESTORE_INTERVAL_MS = 40,
+    // frames to wait after a change of the level of detail, before the next one
+    LOD_COOLDOWN_FRAMES = 10
+  };
+
+  static constexpr double MAX_LOAD = 0.5;
+  static constexpr double MIN_LEVEL_OF_DETAIL = 0.25;
+
+  FrameScheduler(int min_interval_ms, QObject* parent);
+
+  /// Emit frameTriggered() as soon as the current interval allows it.
+  void requestFrame();
+
+  /// Emit frameTriggered() continuously (playback), until stop() is called.
+  void setContinuous(bool enable);
+
+  /// Cancel the pending frame and restore the full level of detail.
+  void stop();
+
+  /// Time since the previous call of endPhase() (or the beginning of the frame)
+  /// is added to the phase. Calls outside of frameTriggered() are ignored.
+  void endPhase(Phase phase);
+
+  /// Add time spent outside of the frame, like painting.
+  void addTime(Phase phase, qint64 nsecs);
+
+  int interval() const
+  {
+    return _interval;
+  }
+
+  double levelOfDetail() const
+  {
+    return _level_of_detail;
+  }
+
+  /// Smoothed duration of a frame, in milliseconds.
+  double frameCost() const
+  {
+    return _cost_ms;
+  }
+
+signals:
+  /// Emitted when it is time to update the data and replot.
+  void frameTriggered();
+
+  void levelOfDetailChanged(double lod);
+
+private:
+  const int _min_interval;
+  int _interval;
+  QTimer* _timer;
+  QElapsedTimer _clock;
+
+  bool _continuous = false;
+  bool _in_frame = false;
+  bool _pending = false;
+
+  qint64 _phase_start = 0;
+  qint64 _frame_start = 0;
+  qint64 _last_duration = 0;
+  std::array<qint64, PHASES_COUNT> _phase_nsecs = {};
+
+  double _cost_ms = 0;
+  double _level_of_detail = 1.0;
+  int _lod_cooldown = 0;
+
+  void onTimeout();
+
+  void scheduleNext();
+
+  void updateEstimate();
+
+  void setLevelOfDetail(double lod);
+};
+
+#endif  // FRAME_SCHEDULER_H
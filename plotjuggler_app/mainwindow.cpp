@@ -4,6 +4,7 @@
  * file, You can obtain one at https://mozilla.org/MPL/2.0/.
  */
 
+#include <atomic>
 #include <functional>
 #include <stdio.h>
 
@@ -24,6 +25,7 @@
 #include <QMimeData>
 #include <QMouseEvent>
 #include <QPluginLoader>
+#include <QProgressDialog>
 #include <QPushButton>
 #include <QKeySequence>
 #include <QScrollBar>
@@ -36,11 +38,14 @@
 #include <QHeaderView>
 #include <QStandardPaths>
 #include <QXmlStreamReader>
+#include <QtConcurrent>
 
 #include "mainwindow.h"
 #include "curvelist_panel.h"
 #include "tabbedplotwidget.h"
 #include "PlotJuggler/plotdata.h"
+#include "PlotJuggler/spill_file.h"
+#include "session_cache.h"
 #include "transforms/function_editor.h"
 #include "transforms/lua_custom_function.h"
 #include "utils.h"
@@ -215,6 +220,25 @@ MainWindow::MainWindow(const QCommandLineParser& commandline_parser, QWidget* pa
     }
   });
 
+  // the painting of the previous frame is part of the cost of the next one
+  _replot_scheduler = new FrameScheduler(40, this);
+  connect(_replot_scheduler, &FrameScheduler::frameTriggered, this, [this]() {
+    _replot_scheduler->addTime(FrameScheduler::RENDER, takePaintTime());
+    updateDataAndReplot(false);
+  });
+
+  _playback_scheduler = new FrameScheduler(20, this);
+  connect(_playback_scheduler, &FrameScheduler::frameTriggered, this, [this]() {
+    _playback_scheduler->addTime(FrameScheduler::RENDER, takePaintTime());
+    onPlaybackLoop();
+  });
+
+  for (auto scheduler : { _replot_scheduler, _playback_scheduler })
+  {
+    connect(scheduler, &FrameScheduler::levelOfDetailChanged, this,
+            &MainWindow::onLevelOfDetailChanged);
+  }
+
   _main_tabbed_widget =
       new TabbedPlotWidget("Main Window", this, _mapped_plot_data, this);
 
@@ -253,14 +277,6 @@ MainWindow::MainWindow(const QCommandLineParser& commandline_parser, QWidget* pa
   // save initial state
   onUndoableChange();
 
-  _replot_timer = new QTimer(this);
-  connect(_replot_timer, &QTimer::timeout, this,
-          [this]() { updateDataAndReplot(false); });
-
-  _publish_timer = new QTimer(this);
-  _publish_timer->setInterval(20);
-  connect(_publish_timer, &QTimer::timeout, this, &MainWindow::onPlaybackLoop);
-
   ui->menuFile->setToolTipsVisible(true);
 
   this->setMenuBar(ui->menuBar);
@@ -364,6 +380,10 @@ MainWindow::MainWindow(const QCommandLineParser& commandline_parser, QWidget* pa
   }
   loadStyleSheet(tr(":/resources/stylesheet_%1.qss").arg(theme));
 
+  _memory_budget = settings.value("Preferences::memory_budget_mb", 0).toULongLong() << 20;
+  SpillFile::global().setEnabled(
+      settings.value("Preferences::spill_to_disk", false).toBool());
+
   // builtin messageParsers
   auto json_parser = std::make_shared<JSON_ParserFactory>();
   _parser_factories.insert({ json_parser->encoding(), json_parser });
@@ -486,12 +506,16 @@ void MainWindow::onTrackerTimeUpdated(double absolute_time, bool do_replot)
   updateReactivePlots();
 
   forEachWidget([&](PlotWidget* plot) {
-    plot->setTrackerPosition(_tracker_time);
-    if (do_replot)
+    const bool tracker_visible = plot->setTrackerPosition(_tracker_time);
+    if (do_replot && tracker_visible)
     {
       plot->replot();
     }
   });
+  if (do_replot)
+  {
+    prepareCurves();
+  }
 }
 
 void MainWindow::initializeActions()
@@ -702,6 +726,8 @@ QStringList MainWindow::initializePlugins(QString directory_name)
       if (loader)
       {
         _data_loader.insert(std::make_pair(plugin_name, loader));
+        _data_loader_version[plugin_name] =
+            SessionCache::pluginVersion(fileinfo.absoluteFilePath());
       }
       else if (publisher)
       {
@@ -791,10 +817,9 @@ QStringList MainWindow::initializePlugins(QString directory_name)
                 &MainWindow::on_deleteSerieFromGroup);
 
         connect(streamer, &DataStreamer::dataReceived, this, [this]() {
-          if (isStreamingActive() && !_replot_timer->isActive())
+          if (isStreamingActive())
           {
-            _replot_timer->setSingleShot(true);
-            _replot_timer->start(40);
+            _replot_scheduler->requestFrame();
           }
         });
 
@@ -977,12 +1002,16 @@ void MainWindow::onPlotAdded(PlotWidget* plot)
 
   connect(plot, &PlotWidget::rectChanged, this, &MainWindow::onPlotZoomChanged);
 
+  connect(plot, &PlotWidget::deferredUpdateApplied, this,
+          [this](PlotWidget* updated) { linkedZoomOut({ updated }); });
+
   plot->on_changeTimeOffset(_time_offset.get());
   plot->on_changeDateTimeScale(ui->buttonUseDateTime->isChecked());
   plot->activateGrid(ui->buttonActivateGrid->isChecked());
   plot->enableTracker(!isStreamingActive());
   plot->setKeepRatioXY(ui->buttonRatio->isChecked());
   plot->configureTracker(_tracker_param);
+  plot->setLevelOfDetail(levelOfDetail());
 }
 
 void MainWindow::onPlotZoomChanged(PlotWidget* modified_plot, QRectF new_range)
@@ -1453,6 +1482,40 @@ bool MainWindow::loadDataFromFiles(QStringList filenames)
   return false;
 }
 
+void MainWindow::saveSessionCache(const QString& key, const PlotDataMapRef& data)
+{
+  QProgressDialog progress_dialog(tr("Writing the data in the cache..."), tr("Skip"), 0,
+                                  100, this);
+  progress_dialog.setWindowTitle("PlotJuggler");
+  progress_dialog.setWindowModality(Qt::ApplicationModal);
+  progress_dialog.setMinimumDuration(500);
+
+  // data is not modified until the worker is done: the dialog is modal and
+  // data is imported only after this function returns.
+  std::atomic_int percent = 0;
+  std::atomic_bool cancelled = false;
+  QFutureWatcher<bool> watcher;
+  QEventLoop loop;
+  connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+  watcher.setFuture(QtConcurrent::run([&]() {
+    return SessionCache::save(key, data, [&](double fraction) {
+      percent = int(100 * fraction);
+      return !cancelled;
+    });
+  }));
+
+  QTimer timer;
+  connect(&timer, &QTimer::timeout, [&]() {
+    progress_dialog.setValue(percent);
+    cancelled = progress_dialog.wasCanceled();
+  });
+  timer.start(100);
+  if (!watcher.isFinished())
+  {
+    loop.exec();
+  }
+}
+
 std::unordered_set<std::string> MainWindow::loadDataFromFile(const FileLoadInfo& info)
 {
   ui->buttonPlay->setChecked(false);
@@ -1534,12 +1597,46 @@ std::unordered_set<std::string> MainWindow::loadDataFromFile(const FileLoadInfo&
       PlotDataMapRef mapped_data;
       FileLoadInfo new_info = info;
 
+      const bool use_cache =
+          QSettings().value("Preferences::session_cache", false).toBool();
+      const auto version_it = _data_loader_version.find(dataloader->name());
+      const QString plugin_version = (version_it != _data_loader_version.end()) ?
+                                         version_it->second :
+                                         SessionCache::pluginVersion({});
+      bool loaded = false;
+
       if (info.plugin_config.hasChildNodes())
       {
         dataloader->xmlLoadState(info.plugin_config.firstChildElement());
+
+        // the same file was already parsed with this configuration
+        if (use_cache)
+        {
+          const QString key =
+              SessionCache::key(info.filename, dataloader->name(), plugin_version,
+                                info.plugin_config.firstChildElement());
+          loaded = SessionCache::load(key, mapped_data);
+        }
+      }
+
+      if (!loaded)
+      {
+        loaded = dataloader->readDataFromFile(&new_info, mapped_data);
+
+        // readDataFromFile() includes the configuration dialog of the plugin:
+        // its duration is not a good estimate of the time spent parsing.
+        const qint64 min_size = qint64(SessionCache::MIN_FILE_SIZE_MB) * 1024 * 1024;
+        if (loaded && use_cache && QFileInfo(info.filename).size() >= min_size)
+        {
+          QDomDocument config;
+          const QString key =
+              SessionCache::key(info.filename, dataloader->name(), plugin_version,
+                                dataloader->xmlSaveState(config));
+          saveSessionCache(key, mapped_data);
+        }
       }
 
-      if (dataloader->readDataFromFile(&new_info, mapped_data))
+      if (loaded)
       {
         AddPrefixToPlotData(info.prefix.toStdString(), mapped_data.numeric);
         AddPrefixToPlotData(info.prefix.toStdString(), mapped_data.strings);
@@ -1647,6 +1744,8 @@ void MainWindow::on_buttonStreamingPause_toggled(bool paused)
   }
   else
   {
+    // restore the full level of detail
+    _replot_scheduler->stop();
     onUndoableChange();
   }
 }
@@ -1685,6 +1784,7 @@ void MainWindow::stopStreamingPlugin()
     _active_streamer_plugin->shutdown();
     _active_streamer_plugin = nullptr;
   }
+  _streamer_batch.clear();
 
   if (!_mapped_plot_data.numeric.empty())
   {
@@ -1693,6 +1793,7 @@ void MainWindow::stopStreamingPlugin()
 
   // reset max range.
   _mapped_plot_data.setMaximumRangeX(std::numeric_limits<double>::max());
+  _mapped_plot_data.setRingBufferMode(false);
 }
 
 void MainWindow::startStreamingPlugin(QString streamer_name)
@@ -2279,6 +2380,13 @@ bool MainWindow::loadLayoutFromFile(QString filename)
 }
 
 void MainWindow::linkedZoomOut()
+{
+  std::set<PlotWidget*> plots;
+  forEachWidget([&](PlotWidget* plot) { plots.insert(plot); });
+  linkedZoomOut(plots);
+}
+
+void MainWindow::linkedZoomOut(const std::set<PlotWidget*>& plots)
 {
   if (ui->buttonLink->isChecked())
   {
@@ -2289,6 +2397,16 @@ void MainWindow::linkedZoomOut()
       {
         if (PlotDocker* matrix = dynamic_cast<PlotDocker*>(tabs->widget(t)))
         {
+          // the linked range changes only if one of the plots changed
+          bool modified = false;
+          for (int index = 0; index < matrix->plotCount(); index++)
+          {
+            modified |= (plots.count(matrix->plotAt(index)) != 0);
+          }
+          if (!modified)
+          {
+            continue;
+          }
           bool first = true;
           Range range;
           // find the ideal zoom
@@ -2333,7 +2451,10 @@ void MainWindow::linkedZoomOut()
   }
   else
   {
-    this->forEachWidget([](PlotWidget* plot) { plot->zoomOut(false); });
+    for (auto plot : plots)
+    {
+      plot->zoomOut(false);
+    }
   }
 }
 
@@ -2373,6 +2494,38 @@ void MainWindow::forEachWidget(std::function<void(PlotWidget*)> op)
   forEachWidget([&](PlotWidget* plot, PlotDocker*, int) { op(plot); });
 }
 
+qint64 MainWindow::takePaintTime()
+{
+  qint64 nsecs = 0;
+  forEachWidget([&](PlotWidget* plot) { nsecs += plot->takePaintTime(); });
+  return nsecs;
+}
+
+double MainWindow::levelOfDetail() const
+{
+  return std::min(_replot_scheduler->levelOfDetail(),
+                  _playback_scheduler->levelOfDetail());
+}
+
+void MainWindow::onLevelOfDetailChanged()
+{
+  const double lod = levelOfDetail();
+  forEachWidget([&](PlotWidget* plot) {
+    if (plot->levelOfDetail() != lod)
+    {
+      plot->setLevelOfDetail(lod);
+      plot->replot();
+    }
+  });
+}
+
+void MainWindow::prepareCurves()
+{
+  std::vector<PlotWidgetBase*> widgets;
+  forEachWidget([&](PlotWidget* plot) { widgets.push_back(plot); });
+  PlotWidgetBase::prepareCurves(widgets);
+}
+
 void MainWindow::updateTimeSlider()
 {
   auto range = calculateVisibleRangeX();
@@ -2401,16 +2554,16 @@ void MainWindow::updateTimeOffset()
 
 void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
 {
-  _replot_timer->stop();
-
   MoveDataRet move_ret;
 
   if (_active_streamer_plugin)
   {
     {
+      // keep the lock short: the points are merged after releasing it
       std::lock_guard<std::mutex> lock(_active_streamer_plugin->mutex());
-      move_ret = MoveData(_active_streamer_plugin->dataMap(), _mapped_plot_data, false);
+      DetachData(_active_streamer_plugin->dataMap(), _streamer_batch);
     }
+    move_ret = MoveData(_streamer_batch, _mapped_plot_data, false);
 
     for (const auto& str : move_ret.added_curves)
     {
@@ -2423,9 +2576,16 @@ void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
     }
 
     _mapped_plot_data.setMaximumRangeX(ui->streamingSpinBox->value());
+    _mapped_plot_data.setRingBufferMode(true);
+
+    if (_memory_budget > 0)
+    {
+      _mapped_plot_data.enforceMemoryBudget(_memory_budget);
+    }
   }
 
   const bool is_streaming_active = isStreamingActive();
+  _replot_scheduler->endPhase(FrameScheduler::MERGE);
 
   //--------------------------------
   std::vector<TransformFunction*> transforms;
@@ -2450,7 +2610,20 @@ void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
     }
   }
 
-  forEachWidget([](PlotWidget* plot) { plot->updateCurves(false); });
+  // only the plots whose series were modified are updated and zoomed
+  std::set<PlotWidget*> updated_plots;
+  forEachWidget([&](PlotWidget* plot) {
+    if (plot->updateCurves(false))
+    {
+      updated_plots.insert(plot);
+      if (is_streaming_active)
+      {
+        // the series received only new samples
+        plot->allowIncrementalPaint();
+      }
+    }
+  });
+  _replot_scheduler->endPhase(FrameScheduler::TRANSFORM);
 
   //--------------------------------
   // trigger again the execution of this callback if steaming == true
@@ -2467,7 +2640,12 @@ void MainWindow::updateDataAndReplot(bool replot_hidden_tabs)
     updateTimeSlider();
   }
   //--------------------------------
-  linkedZoomOut();
+  linkedZoomOut(updated_plots);
+
+  // compress again the chunks decompressed by the transforms
+  _mapped_plot_data.compressColdChunks();
+
+  prepareCurves();
 }
 
 void MainWindow::on_streamingSpinBox_valueChanged(int value)
@@ -2553,13 +2731,9 @@ void MainWindow::on_buttonPlay_toggled(bool checked)
 {
   if (checked)
   {
-    _publish_timer->start();
     _prev_publish_time = QDateTime::currentDateTime();
   }
-  else
-  {
-    _publish_timer->stop();
-  }
+  _playback_scheduler->setContinuous(checked);
 }
 
 void MainWindow::on_actionClearBuffer_triggered()
@@ -2579,6 +2753,11 @@ void MainWindow::on_actionClearBuffer_triggered()
     it.second.clear();
   }
 
+  for (auto& it : _mapped_plot_data.blobs)
+  {
+    it.second.clear();
+  }
+
   for (auto& it : _transform_functions)
   {
     it.second->reset();
@@ -2607,6 +2786,7 @@ void MainWindow::on_deleteSerieFromGroup(std::string group_name)
   AddFromGroup(_mapped_plot_data.numeric);
   AddFromGroup(_mapped_plot_data.strings);
   AddFromGroup(_mapped_plot_data.user_defined);
+  AddFromGroup(_mapped_plot_data.blobs);
 
   onDeleteMultipleCurves(names);
 }
@@ -2673,8 +2853,8 @@ void MainWindow::on_buttonTimeTracker_pressed()
 
 void MainWindow::closeEvent(QCloseEvent* event)
 {
-  _replot_timer->stop();
-  _publish_timer->stop();
+  _replot_scheduler->stop();
+  _playback_scheduler->stop();
 
   if (_active_streamer_plugin)
   {
@@ -2750,7 +2930,7 @@ void MainWindow::onPlaybackLoop()
   qint64 delta_ms =
       (QDateTime::currentMSecsSinceEpoch() - _prev_publish_time.toMSecsSinceEpoch());
   _prev_publish_time = QDateTime::currentDateTime();
-  delta_ms = std::max((qint64)_publish_timer->interval(), delta_ms);
+  delta_ms = std::max((qint64)_playback_scheduler->interval(), delta_ms);
 
   _tracker_time += delta_ms * 0.001 * ui->playbackRate->value();
   if (_tracker_time >= ui->timeSlider->getMaximum())
@@ -2775,11 +2955,15 @@ void MainWindow::onPlaybackLoop()
   {
     it.second->play(_tracker_time);
   }
+  _playback_scheduler->endPhase(FrameScheduler::TRANSFORM);
 
   forEachWidget([&](PlotWidget* plot) {
-    plot->setTrackerPosition(_tracker_time);
-    plot->replot();
+    if (plot->setTrackerPosition(_tracker_time))
+    {
+      plot->replot();
+    }
   });
+  prepareCurves();
 }
 
 void MainWindow::onCustomPlotCreated(std::vector<CustomPlotPtr> custom_plots)
@@ -3286,6 +3470,10 @@ void MainWindow::on_actionPreferences_triggered()
   {
     loadStyleSheet(tr(":/resources/stylesheet_%1.qss").arg(theme));
   }
+
+  _memory_budget = settings.value("Preferences::memory_budget_mb", 0).toULongLong() << 20;
+  SpillFile::global().setEnabled(
+      settings.value("Preferences::spill_to_disk", false).toBool());
 }
 
 void MainWindow::on_playbackStep_valueChanged(double step)
@@ -24,6 +24,7 @@
 #include "tabbedplotwidget.h"
 #include "realslider.h"
 #include "utils.h"
+#include "frame_scheduler.h"
 #include "PlotJuggler/dataloader_base.h"
 #include "PlotJuggler/statepublisher_base.h"
 #include "PlotJuggler/toolbox_base.h"
@@ -121,9 +122,14 @@ private:
 
   PlotDataMapRef _mapped_plot_data;
 
+  // data taken from the streamer and not merged yet. See DetachData()
+  PlotDataMapRef _streamer_batch;
+
   TransformsMap _transform_functions;
 
   std::map<QString, DataLoaderPtr> _data_loader;
+  // see SessionCache::pluginVersion()
+  std::map<QString, QString> _data_loader_version;
   std::map<QString, StatePublisherPtr> _state_publisher;
   std::map<QString, DataStreamerPtr> _data_streamer;
   std::map<QString, ToolboxPluginPtr> _toolboxes;
@@ -145,6 +151,8 @@ private:
 
   double _tracker_time;
 
+  size_t _memory_budget = 0;  // bytes, 0 means no limit
+
   QStringList _enabled_plugins;
   QStringList _disabled_plugins;
 
@@ -156,8 +164,8 @@ private:
 
   MonitoredValue _time_offset;
 
-  QTimer* _replot_timer;
-  QTimer* _publish_timer;
+  FrameScheduler* _replot_scheduler;
+  FrameScheduler* _playback_scheduler;
   PJ::DelayedCallback _tracker_delay;
 
   QDateTime _prev_publish_time;
@@ -187,6 +195,20 @@ private:
   void forEachWidget(std::function<void(PlotWidget*, PlotDocker*, int)> op);
   void forEachWidget(std::function<void(PlotWidget*)> op);
 
+  // compute the curves to be painted in a pool of threads
+  void prepareCurves();
+
+  // zoom out only these plots, or the tabs that contain them if linked
+  void linkedZoomOut(const std::set<PlotWidget*>& plots);
+
+  // time spent painting the plots since the previous call, in nanoseconds
+  qint64 takePaintTime();
+
+  // the lowest level of detail requested by the frame schedulers
+  double levelOfDetail() const;
+
+  void onLevelOfDetailChanged();
+
   void rearrangeGridLayout();
 
   QDomDocument xmlSaveState() const;
@@ -196,6 +218,9 @@ private:
 
   void importPlotDataMap(PlotDataMapRef& new_data, bool remove_old);
 
+  // write data in the SessionCache, in a worker thread, showing the progress
+  void saveSessionCache(const QString& key, const PlotDataMapRef& data);
+
   bool isStreamingActive() const;
 
   void closeEvent(QCloseEvent* event);
@@ -1048,8 +1048,9 @@ bool PlotWidget::isTrackerEnabled() const
   return _tracker->isEnabled();
 }
 
-void PlotWidget::setTrackerPosition(double abs_time)
+bool PlotWidget::setTrackerPosition(double abs_time)
 {
+  bool moved = false;
   if (isXYPlot())
   {
     for (auto& it : curveList())
@@ -1057,18 +1058,26 @@ void PlotWidget::setTrackerPosition(double abs_time)
       if (auto series = dynamic_cast<QwtTimeseries*>(it.curve->data()))
       {
         auto pointXY = series->sampleFromTime(abs_time);
-        if (pointXY)
+        if (pointXY && pointXY.value() != it.marker->value())
         {
           it.marker->setValue(pointXY.value());
+          moved |= it.marker->isVisible();
         }
       }
     }
+    return moved;
   }
-  else
-  {
-    double relative_time = abs_time - _time_offset;
-    _tracker->setPosition(QPointF(relative_time, 0.0));
-  }
+
+  const double prev_time = _tracker->actualPosition().x();
+  const double relative_time = abs_time - _time_offset;
+  _tracker->setPosition(QPointF(relative_time, 0.0));
+
+  // nothing to repaint if both the old and the new position are out of view
+  const auto x_map = qwtPlot()->canvasMap(QwtPlot::xBottom);
+  const double left = std::min(x_map.s1(), x_map.s2());
+  const double right = std::max(x_map.s1(), x_map.s2());
+  auto in_view = [&](double x) { return x >= left && x <= right; };
+  return _tracker->isEnabled() && (in_view(prev_time) || in_view(relative_time));
 }
 
 void PlotWidget::on_changeTimeOffset(double offset)
@@ -1147,16 +1156,49 @@ Range PlotWidget::getVisualizationRangeY(Range range_X) const
   return Range({ bottom, top });
 }
 
-void PlotWidget::updateCurves(bool reset_older_data)
+bool PlotWidget::updateCurves(bool reset_older_data)
 {
+  if (!isVisible())
+  {
+    _update_deferred = true;
+    _deferred_reset |= reset_older_data;
+    return false;
+  }
+  reset_older_data |= _deferred_reset;
+  _update_deferred = false;
+  _deferred_reset = false;
+
+  std::vector<std::pair<const QwtSeriesWrapper*, uint64_t>> epochs;
+  epochs.reserve(curveList().size());
+  for (auto& it : curveList())
+  {
+    auto series = dynamic_cast<QwtSeriesWrapper*>(it.curve->data());
+    epochs.push_back({ series, series->sourceEpoch() });
+  }
+  if (!reset_older_data && epochs == _source_epochs)
+  {
+    return false;
+  }
+
   for (auto& it : curveList())
   {
     auto series = dynamic_cast<QwtSeriesWrapper*>(it.curve->data());
     series->updateCache(reset_older_data);
   }
+  _source_epochs = std::move(epochs);
   updateMaximumZoomArea();
 
   updateStatistics(true);
+  return true;
+}
+
+void PlotWidget::showEvent(QShowEvent* event)
+{
+  PlotWidgetBase::showEvent(event);
+  if (_update_deferred && updateCurves(false))
+  {
+    emit deferredUpdateApplied(this);
+  }
 }
 
 void PlotWidget::updateStatistics(bool forceUpdate)
@@ -1719,9 +1761,12 @@ QwtSeriesWrapper* PlotWidget::createCurveXY(const PlotData* data_x,
 {
   PointSeriesXY* output = nullptr;
 
+  QSettings settings;
+  const double tolerance_ms =
+      settings.value("Preferences::xy_time_tolerance_ms", 0.0).toDouble();
   try
   {
-    output = new PointSeriesXY(data_x, data_y);
+    output = new PointSeriesXY(data_x, data_y, tolerance_ms * 0.001);
   }
   catch (std::runtime_error& ex)
   {
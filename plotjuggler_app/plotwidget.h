@@ -92,6 +92,8 @@ protected:
 
   bool canvasEventFilter(QEvent* event);
 
+  void showEvent(QShowEvent* event) override;
+
 signals:
   void swapWidgetsRequested(PlotWidget* source, PlotWidget* destination);
   void rectChanged(PlotWidget* self, QRectF rect);
@@ -101,10 +103,20 @@ signals:
   void curvesDropped();
   void splitHorizontal();
   void splitVertical();
+  // the curves were updated when the widget was shown, see updateCurves()
+  void deferredUpdateApplied(PlotWidget* self);
 
 public slots:
 
-  void updateCurves(bool reset_older_data);
+  /**
+   * @brief Update the cached curves, the maximum zoom area and the statistics.
+   * Nothing is done if none of the source series was modified since the
+   * previous call, unless reset_older_data is true.
+   * If the widget is hidden, the update is deferred until it is shown.
+   *
+   * @return true if the curves were updated.
+   */
+  bool updateCurves(bool reset_older_data);
 
   void onDataSourceRemoved(const std::string& src_name);
 
@@ -128,7 +140,8 @@ public slots:
 
   bool isTrackerEnabled() const;
 
-  void setTrackerPosition(double abs_time);
+  /// @return true if the tracker is visible: the plot must be replotted.
+  bool setTrackerPosition(double abs_time);
 
   void on_changeTimeOffset(double offset);
 
@@ -227,6 +240,11 @@ private:
 
   bool _context_menu_enabled;
 
+  // modification epochs of the series of each curve, in the last updateCurves()
+  std::vector<std::pair<const QwtSeriesWrapper*, uint64_t>> _source_epochs;
+  bool _update_deferred = false;
+  bool _deferred_reset = false;
+
   // void updateMaximumZoomArea();
   void rescaleEqualAxisScaling();
   void overrideCursonMove();
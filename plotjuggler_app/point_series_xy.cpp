@@ -5,16 +5,24 @@
  */
 
 #include "point_series_xy.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 
-PointSeriesXY::PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis)
+PointSeriesXY::PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis,
+                             double time_tolerance)
   : QwtTimeseries(nullptr)
   , _x_axis(x_axis)
   , _y_axis(y_axis)
+  , _time_tolerance(time_tolerance)
   , _cached_curve("", x_axis->group())
 {
   updateCache(true);
+
+  if (_cached_curve.size() == 0 && _x_axis->size() > 0 && _y_axis->size() > 0)
+  {
+    throw std::runtime_error("X and Y axis don't share the same time axis");
+  }
 }
 
 size_t PointSeriesXY::size() const
@@ -22,58 +30,210 @@ size_t PointSeriesXY::size() const
   return _cached_curve.size();
 }
 
-std::optional<QPointF> PointSeriesXY::sampleFromTime(double t)
+QRectF PointSeriesXY::boundingRect() const
 {
-  if (_cached_curve.size() == 0)
+  if (_timestamps.empty())
   {
     return {};
   }
+  QRectF box;
+  box.setLeft(_range_x.min.front());
+  box.setRight(_range_x.max.front());
+  box.setTop(_range_y.max.front());
+  box.setBottom(_range_y.min.front());
+  return box;
+}
 
-  int index = _y_axis->getIndexFromX(t);
-  if (index < 0)
+std::optional<QPointF> PointSeriesXY::sampleFromTime(double t)
+{
+  if (_timestamps.empty())
   {
     return {};
   }
-  const auto& p = _cached_curve.at(size_t(index));
+  // nearest point
+  size_t index = std::lower_bound(_timestamps.begin(), _timestamps.end(), t) -
+                 _timestamps.begin();
+  if (index == _timestamps.size() ||
+      (index > 0 && (t - _timestamps[index - 1]) < (_timestamps[index] - t)))
+  {
+    index--;
+  }
+  const auto& p = _cached_curve.at(index);
   return QPointF(p.x, p.y);
 }
 
 RangeOpt PointSeriesXY::getVisualizationRangeY(Range)
 {
-  return _cached_curve.rangeY();
+  if (_timestamps.empty())
+  {
+    return {};
+  }
+  return Range{ _range_y.min.front(), _range_y.max.front() };
 }
 
-void PointSeriesXY::updateCache(bool reset_old_data)
+RangeOpt PointSeriesXY::getVisualizationRangeX()
 {
-  _cached_curve.clear();
+  if (_timestamps.empty())
+  {
+    return {};
+  }
+  return Range{ _range_x.min.front(), _range_x.max.front() };
+}
 
+void PointSeriesXY::updateCache(bool reset_old_data)
+{
   if (_x_axis == nullptr)
   {
     throw std::runtime_error("the X axis is null");
   }
 
-  const size_t data_size = std::min(_x_axis->size(), _y_axis->size());
+  if (reset_old_data || !sourcesWereAppended())
+  {
+    clearCache();
+  }
+  removeOldPoints();
+  joinNewSamples();
+}
+
+void PointSeriesXY::clearCache()
+{
+  _cached_curve.clear();
+  _timestamps.clear();
+  _range_x.clear();
+  _range_y.clear();
+  _scan_x = std::numeric_limits<double>::lowest();
+  _scan_y = std::numeric_limits<double>::lowest();
+}
 
-  if (data_size == 0)
+// True if the samples of the last point are still in the series: they received
+// new samples, or lost the oldest ones, but the others were not modified.
+bool PointSeriesXY::sourcesWereAppended() const
+{
+  if (_timestamps.empty())
+  {
+    return true;
+  }
+  auto contains = [](const PlotData* data, double time, double value) {
+    const size_t index = data->columns().lowerBound(time);
+    return index < data->size() && data->at(index).x == time &&
+           data->at(index).y == value;
+  };
+  const PlotDataXY::Point last = _cached_curve.back();
+  return contains(_x_axis, _last_joined_x, last.x) &&
+         contains(_y_axis, _timestamps.back(), last.y);
+}
+
+void PointSeriesXY::removeOldPoints()
+{
+  if (_timestamps.empty())
   {
     return;
   }
+  // the X sample of a point can be older than its Y sample, by the tolerance
+  const double min_time =
+      std::max(_y_axis->front().x, _x_axis->front().x - _time_tolerance);
+
+  while (!_timestamps.empty() && _timestamps.front() < min_time)
+  {
+    const PlotDataXY::Point p = _cached_curve.front();
+    _range_x.pop(p.x);
+    _range_y.pop(p.y);
+    _cached_curve.popFront();
+    _timestamps.pop_front();
+  }
+}
+
+void PointSeriesXY::joinNewSamples()
+{
+  const PlotData& xs = *_x_axis;
+  const PlotData& ys = *_y_axis;
+  const size_t size_x = xs.size();
+  const size_t size_y = ys.size();
+  size_t ix = xs.columns().upperBound(_scan_x);
+  size_t iy = ys.columns().upperBound(_scan_y);
 
-  const double EPS = std::numeric_limits<double>::epsilon();
+  const double tolerance =
+      std::max(_time_tolerance, std::numeric_limits<double>::epsilon());
 
-  for (size_t i = 0; i < data_size; i++)
+  // merge join. A sample is skipped only if a newer sample of the other series
+  // is too far already: the samples received later can't match it either.
+  while (ix < size_x && iy < size_y)
   {
-    if (std::abs(_x_axis->at(i).x - _y_axis->at(i).x) > EPS)
+    // copies: reading other samples may release the chunks they point to
+    const PlotData::Point px = xs.at(ix);
+    const PlotData::Point py = ys.at(iy);
+
+    if (px.x < py.x - tolerance)
+    {
+      _scan_x = px.x;
+      ix++;
+      continue;
+    }
+    if (py.x < px.x - tolerance)
+    {
+      _scan_y = py.x;
+      iy++;
+      continue;
+    }
+    // if the next sample of one of the series is even closer, use that
+    const double distance = std::abs(px.x - py.x);
+    if (ix + 1 < size_x && std::abs(xs.at(ix + 1).x - py.x) < distance)
+    {
+      _scan_x = px.x;
+      ix++;
+      continue;
+    }
+    if (iy + 1 < size_y && std::abs(ys.at(iy + 1).x - px.x) < distance)
+    {
+      _scan_y = py.x;
+      iy++;
+      continue;
+    }
+
+    if (std::isfinite(px.y) && std::isfinite(py.y))
     {
-      throw std::runtime_error("X and Y axis don't share the same time axis");
+      _cached_curve.pushBack({ px.y, py.y });
+      _timestamps.push_back(py.x);
+      _range_x.push(px.y);
+      _range_y.push(py.y);
+      _last_joined_x = px.x;
     }
+    _scan_x = px.x;
+    _scan_y = py.x;
+    ix++;
+    iy++;
+  }
+}
+
+void PointSeriesXY::SlidingRange::push(double value)
+{
+  while (!max.empty() && max.back() < value)
+  {
+    max.pop_back();
+  }
+  max.push_back(value);
+
+  while (!min.empty() && min.back() > value)
+  {
+    min.pop_back();
+  }
+  min.push_back(value);
+}
 
-    const QPointF p(_x_axis->at(i).y, _y_axis->at(i).y);
-    _cached_curve.pushBack({ p.x(), p.y() });
+void PointSeriesXY::SlidingRange::pop(double value)
+{
+  if (!max.empty() && max.front() == value)
+  {
+    max.pop_front();
+  }
+  if (!min.empty() && min.front() == value)
+  {
+    min.pop_front();
   }
 }
 
-RangeOpt PointSeriesXY::getVisualizationRangeX()
+void PointSeriesXY::SlidingRange::clear()
 {
-  return _cached_curve.rangeX();
+  min.clear();
+  max.clear();
 }
@@ -7,12 +7,32 @@
 #ifndef POINT_SERIES_H
 #define POINT_SERIES_H
 
+#include <deque>
 #include "timeseries_qwt.h"
 
+/**
+ * @brief XY curve made of the samples of two timeseries, joined by timestamp.
+ *
+ * The curve is built incrementally: updateCache() joins only the samples
+ * received after the last point, and removes the points whose samples were
+ * removed from the front of the series (streaming buffer).
+ * The bounding box is updated in amortized O(1) too.
+ *
+ * Samples inserted before the last point (late samples) are not joined until
+ * the curve is rebuilt with updateCache(true).
+ */
 class PointSeriesXY : public QwtTimeseries
 {
 public:
-  PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis);
+  /**
+   * @param time_tolerance  maximum distance, in seconds, between the timestamps of
+   * two samples of x_axis and y_axis that are joined in a point. If zero, they
+   * must be identical. Samples without a match are skipped.
+   *
+   * @throw std::runtime_error if no sample of the two series can be joined.
+   */
+  PointSeriesXY(const PlotData* x_axis, const PlotData* y_axis,
+                double time_tolerance = 0.0);
 
   virtual QPointF sample(size_t i) const override
   {
@@ -22,12 +42,20 @@ public:
 
   size_t size() const override;
 
+  QRectF boundingRect() const override;
+
   std::optional<QPointF> sampleFromTime(double t) override;
 
   RangeOpt getVisualizationRangeY(Range range_X) override;
 
   void updateCache(bool reset_old_data) override;
 
+  // both epochs only increase: the sum changes when either of them does
+  uint64_t sourceEpoch() const override
+  {
+    return _x_axis->modificationEpoch() + _y_axis->modificationEpoch();
+  }
+
   RangeOpt getVisualizationRangeX() override;
 
   const PlotData* dataX() const
@@ -39,15 +67,52 @@ public:
     return _y_axis;
   }
 
+  double timeTolerance() const
+  {
+    return _time_tolerance;
+  }
+
   const PlotDataXY* plotData() const override
   {
     return &_cached_curve;
   }
 
 protected:
+  // minimum and maximum of a FIFO of values, in amortized O(1)
+  struct SlidingRange
+  {
+    std::deque<double> min;
+    std::deque<double> max;
+
+    void push(double value);
+    // value must be the one at the front of the FIFO
+    void pop(double value);
+    void clear();
+  };
+
   const PlotData* _x_axis;
   const PlotData* _y_axis;
+  const double _time_tolerance;
   PlotDataXY _cached_curve;
+
+  // timestamp (of the Y sample) of each point of _cached_curve
+  std::deque<double> _timestamps;
+  SlidingRange _range_x;
+  SlidingRange _range_y;
+
+  // timestamp of the X sample of the last point
+  double _last_joined_x = 0;
+  // timestamps of the last samples visited by the join, that restarts after them
+  double _scan_x = 0;
+  double _scan_y = 0;
+
+  void clearCache();
+
+  bool sourcesWereAppended() const;
+
+  void removeOldPoints();
+
+  void joinNewSamples();
 };
 
 #endif  // POINT_SERIES_H
@@ -58,6 +58,19 @@ PreferencesDialog::PreferencesDialog(QWidget* parent)
   bool truncation_check = settings.value("Preferences::truncation_check", true).toBool();
   ui->checkBoxTruncation->setChecked(truncation_check);
 
+  double xy_tolerance =
+      settings.value("Preferences::xy_time_tolerance_ms", 0.0).toDouble();
+  ui->spinBoxTimeToleranceXY->setValue(xy_tolerance);
+
+  int memory_budget = settings.value("Preferences::memory_budget_mb", 0).toInt();
+  ui->spinBoxMemoryBudget->setValue(memory_budget);
+
+  bool spill_to_disk = settings.value("Preferences::spill_to_disk", false).toBool();
+  ui->checkBoxSpillToDisk->setChecked(spill_to_disk);
+
+  bool session_cache = settings.value("Preferences::session_cache", false).toBool();
+  ui->checkBoxSessionCache->setChecked(session_cache);
+
   //---------------
   auto custom_plugin_folders =
       settings.value("Preferences::plugin_folders", true).toStringList();
@@ -104,6 +117,11 @@ void PreferencesDialog::on_buttonBox_accepted()
   settings.setValue("Preferences::autozoom_filter_applied",
                     ui->checkBoxAutoZoomFilter->isChecked());
   settings.setValue("Preferences::truncation_check", ui->checkBoxTruncation->isChecked());
+  settings.setValue("Preferences::xy_time_tolerance_ms",
+                    ui->spinBoxTimeToleranceXY->value());
+  settings.setValue("Preferences::memory_budget_mb", ui->spinBoxMemoryBudget->value());
+  settings.setValue("Preferences::spill_to_disk", ui->checkBoxSpillToDisk->isChecked());
+  settings.setValue("Preferences::session_cache", ui->checkBoxSessionCache->isChecked());
 
   QStringList plugin_folders;
   for (int row = 0; row < ui->listWidgetCustom->count(); row++)
@@ -0,0 +1,495 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "session_cache.h"
+#include <cstring>
+#include <unordered_map>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+
+using namespace PJ;
+
+/*
+ * Layout of the file:
+ *
+ *   - MAGIC (8 bytes, it includes the version of the format).
+ *   - size of the header (uint64).
+ *   - header, written with QDataStream: key, groups and, for each series, its
+ *     name, group, attributes, number of points and offset of its columns.
+ *   - padding to a multiple of 8 bytes.
+ *   - columns. Numeric and XY series: all the x, then all the y (double).
+ *     String series: all the x (double), then the index of each value in the
+ *     dictionary of the series (uint32), padded to 8 bytes.
+ *
+ * Offsets are relative to the beginning of the columns. Numbers are stored
+ * with the byte order of the machine: the cache is not meant to be shared.
+ */
+namespace
+{
+const char MAGIC[8] = { 'P', 'J', 'C', 'A', 'C', 'H', 'E', '1' };
+
+struct SeriesHeader
+{
+  QString name;
+  QString group;
+  Attributes attributes;
+  quint64 size = 0;
+  quint64 offset = 0;
+  std::vector<QByteArray> dictionary;  // only string series
+};
+
+quint64 PadTo8(quint64 bytes)
+{
+  return (bytes + 7) & ~quint64(7);
+}
+
+quint64 ColumnsSize(const SeriesHeader& series, bool is_string)
+{
+  if (is_string)
+  {
+    return series.size * sizeof(double) + PadTo8(series.size * sizeof(uint32_t));
+  }
+  return series.size * 2 * sizeof(double);
+}
+
+void WriteAttributes(QDataStream& out, const Attributes& attributes)
+{
+  out << quint32(attributes.size());
+  for (const auto& [id, value] : attributes)
+  {
+    out << qint32(id) << value;
+  }
+}
+
+void ReadAttributes(QDataStream& in, Attributes& attributes)
+{
+  quint32 count = 0;
+  in >> count;
+  for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+  {
+    qint32 id;
+    QVariant value;
+    in >> id >> value;
+    attributes[PlotAttribute(id)] = value;
+  }
+}
+
+template <class SeriesT>
+QString GroupName(const SeriesT& series)
+{
+  return series.group() ? QString::fromStdString(series.group()->name()) : QString();
+}
+
+void WriteSeries(QDataStream& out, const SeriesHeader& series, bool is_string)
+{
+  out << series.name << series.group;
+  WriteAttributes(out, series.attributes);
+  out << series.size << series.offset;
+  if (is_string)
+  {
+    out << quint32(series.dictionary.size());
+    for (const auto& str : series.dictionary)
+    {
+      out << str;
+    }
+  }
+}
+
+bool ReadSeries(QDataStream& in, std::vector<SeriesHeader>& headers, bool is_string)
+{
+  quint32 count = 0;
+  in >> count;
+  for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+  {
+    SeriesHeader series;
+    in >> series.name >> series.group;
+    ReadAttributes(in, series.attributes);
+    in >> series.size >> series.offset;
+    if (is_string)
+    {
+      quint32 words = 0;
+      in >> words;
+      for (quint32 w = 0; w < words && in.status() == QDataStream::Ok; w++)
+      {
+        QByteArray str;
+        in >> str;
+        series.dictionary.push_back(std::move(str));
+      }
+    }
+    headers.push_back(std::move(series));
+  }
+  return in.status() == QDataStream::Ok;
+}
+
+template <class SeriesMap>
+void AddHeaders(const SeriesMap& map, std::vector<SeriesHeader>& headers,
+                quint64& offset)
+{
+  for (const auto& [name, series] : map)
+  {
+    SeriesHeader header;
+    header.name = QString::fromStdString(name);
+    header.group = GroupName(series);
+    header.attributes = series.attributes();
+    header.size = series.size();
+    header.offset = offset;
+    offset += ColumnsSize(header, false);
+    headers.push_back(std::move(header));
+  }
+}
+
+bool WriteColumns(QSaveFile& file, const PlotDataBase<double, double>& series)
+{
+  bool ok = true;
+  const auto& columns = series.columns();
+  columns.forEachSpan(0, columns.size(),
+                      [&](const double* x, const double*, size_t count) {
+                        ok &= file.write(reinterpret_cast<const char*>(x),
+                                         count * sizeof(double)) >= 0;
+                      });
+  columns.forEachSpan(0, columns.size(),
+                      [&](const double*, const double* y, size_t count) {
+                        ok &= file.write(reinterpret_cast<const char*>(y),
+                                         count * sizeof(double)) >= 0;
+                      });
+  return ok;
+}
+
+// index of each value of the series in the dictionary
+std::vector<uint32_t> BuildDictionary(const StringSeries& series,
+                                      std::vector<QByteArray>& dictionary)
+{
+  std::unordered_map<std::string, uint32_t> words;
+  std::vector<uint32_t> indices;
+  indices.reserve(series.size());
+
+  auto add_words = [&](const double*, const StringRef* y, size_t count) {
+    for (size_t i = 0; i < count; i++)
+    {
+      std::string word(y[i].data(), y[i].size());
+      auto it = words.find(word);
+      if (it == words.end())
+      {
+        const auto index = uint32_t(dictionary.size());
+        dictionary.emplace_back(word.data(), int(word.size()));
+        it = words.insert({ std::move(word), index }).first;
+      }
+      indices.push_back(it->second);
+    }
+  };
+  series.columns().forEachSpan(0, series.size(), add_words);
+  return indices;
+}
+
+PlotGroup::Ptr GetGroup(PlotDataMapRef& data, const QString& name)
+{
+  return name.isEmpty() ? PlotGroup::Ptr() : data.getOrCreateGroup(name.toStdString());
+}
+
+}  // namespace
+
+QString SessionCache::key(const QString& filename, const QString& plugin_name,
+                          const QString& plugin_version, const QDomElement& plugin_config)
+{
+  QFileInfo info(filename);
+  QString config;
+  QTextStream stream(&config);
+  plugin_config.save(stream, 0);
+
+  return QString("%1\n%2\n%3\n%4\n%5\n%6")
+      .arg(info.absoluteFilePath())
+      .arg(info.size())
+      .arg(info.lastModified().toMSecsSinceEpoch())
+      .arg(plugin_name)
+      .arg(plugin_version)
+      .arg(config);
+}
+
+QString SessionCache::pluginVersion(const QString& plugin_file)
+{
+  QString version = QCoreApplication::applicationVersion();
+  QFileInfo info(plugin_file);
+  if (!plugin_file.isEmpty() && info.exists())
+  {
+    version += QString(" %1 %2").arg(info.size()).arg(
+        info.lastModified().toMSecsSinceEpoch());
+  }
+  return version;
+}
+
+QString SessionCache::directory()
+{
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+         "/session_cache";
+}
+
+QString SessionCache::filePath(const QString& key)
+{
+  auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+  return directory() + "/" + QString::fromLatin1(hash.toHex()) + ".pjcache";
+}
+
+bool SessionCache::save(const QString& key, const PlotDataMapRef& data,
+                        const ProgressCallback& progress)
+{
+  if (!data.user_defined.empty() || !data.blobs.empty())
+  {
+    return false;
+  }
+  if (!QDir().mkpath(directory()))
+  {
+    return false;
+  }
+
+  std::vector<SeriesHeader> numeric;
+  std::vector<SeriesHeader> scatter_xy;
+  std::vector<SeriesHeader> strings;
+  std::vector<std::vector<uint32_t>> string_indices;
+
+  quint64 offset = 0;
+  AddHeaders(data.numeric, numeric, offset);
+  AddHeaders(data.scatter_xy, scatter_xy, offset);
+
+  for (const auto& [name, series] : data.strings)
+  {
+    SeriesHeader header;
+    header.name = QString::fromStdString(name);
+    header.group = GroupName(series);
+    header.attributes = series.attributes();
+    header.size = series.size();
+    header.offset = offset;
+
+    auto indices = BuildDictionary(series, header.dictionary);
+    offset += ColumnsSize(header, true);
+    strings.push_back(std::move(header));
+    string_indices.push_back(std::move(indices));
+  }
+
+  // it would evict all the other files, and be removed anyway
+  if (offset > quint64(MAX_TOTAL_MB) * 1024 * 1024)
+  {
+    return false;
+  }
+
+  QByteArray header;
+  {
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out << key;
+    out << quint32(data.groups.size());
+    for (const auto& [name, group] : data.groups)
+    {
+      out << QString::fromStdString(name);
+      WriteAttributes(out, group->attributes());
+    }
+    for (const auto* headers : { &numeric, &scatter_xy, &strings })
+    {
+      out << quint32(headers->size());
+      for (const auto& series : *headers)
+      {
+        WriteSeries(out, series, headers == &strings);
+      }
+    }
+  }
+
+  // QSaveFile replaces the previous file only if everything was written
+  QSaveFile file(filePath(key));
+  if (!file.open(QIODevice::WriteOnly))
+  {
+    return false;
+  }
+  const quint64 header_size = header.size();
+  const QByteArray padding(8, '\0');
+  bool ok = file.write(MAGIC, sizeof(MAGIC)) == sizeof(MAGIC);
+  ok &= file.write(reinterpret_cast<const char*>(&header_size), sizeof(header_size)) ==
+        sizeof(header_size);
+  ok &= file.write(header) == header.size();
+  ok &= file.write(padding.constData(), PadTo8(header_size) - header_size) >= 0;
+
+  // called after each series; writing is cancelled if it returns false
+  const double file_size = double(file.pos() + offset);
+  auto keep_going = [&]() { return !progress || progress(file.pos() / file_size); };
+
+  for (const auto& series : numeric)
+  {
+    ok = ok && WriteColumns(file, data.numeric.at(series.name.toStdString())) &&
+         keep_going();
+  }
+  for (const auto& series : scatter_xy)
+  {
+    ok = ok && WriteColumns(file, data.scatter_xy.at(series.name.toStdString())) &&
+         keep_going();
+  }
+  for (size_t i = 0; i < strings.size() && ok; i++)
+  {
+    const auto& columns = data.strings.at(strings[i].name.toStdString()).columns();
+    columns.forEachSpan(0, columns.size(),
+                        [&](const double* x, const StringRef*, size_t count) {
+                          ok &= file.write(reinterpret_cast<const char*>(x),
+                                           count * sizeof(double)) >= 0;
+                        });
+    const auto& indices = string_indices[i];
+    const qint64 bytes = indices.size() * sizeof(uint32_t);
+    ok &= file.write(reinterpret_cast<const char*>(indices.data()), bytes) == bytes;
+    ok &= file.write(padding.constData(), PadTo8(bytes) - bytes) >= 0;
+    ok = ok && keep_going();
+  }
+
+  // if the file is not committed, QSaveFile removes it
+  if (!ok || !file.commit())
+  {
+    return false;
+  }
+  removeOldFiles();
+  return true;
+}
+
+bool SessionCache::load(const QString& key, PlotDataMapRef& data)
+{
+  QFile file(filePath(key));
+  if (!file.exists() || !file.open(QIODevice::ReadWrite))
+  {
+    return false;
+  }
+  const quint64 file_size = file.size();
+  quint64 header_size = 0;
+  if (file_size < sizeof(MAGIC) + sizeof(header_size))
+  {
+    return false;
+  }
+  // the file is closed (and unmapped) when this function returns
+  const uchar* mapped = file.map(0, file_size);
+  if (!mapped || std::memcmp(mapped, MAGIC, sizeof(MAGIC)) != 0)
+  {
+    return false;
+  }
+  std::memcpy(&header_size, mapped + sizeof(MAGIC), sizeof(header_size));
+  const quint64 header_offset = sizeof(MAGIC) + sizeof(header_size);
+  if (header_size > file_size - header_offset)
+  {
+    return false;
+  }
+  const quint64 columns_offset = header_offset + PadTo8(header_size);
+  const uchar* columns = mapped + columns_offset;
+  const quint64 columns_size = file_size - std::min(columns_offset, file_size);
+
+  // the whole header is validated before modifying data
+  QString stored_key;
+  std::vector<std::pair<QString, Attributes>> groups;
+  std::vector<SeriesHeader> numeric;
+  std::vector<SeriesHeader> scatter_xy;
+  std::vector<SeriesHeader> strings;
+  {
+    auto header = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(mapped + header_offset), int(header_size));
+    QDataStream in(header);
+    in >> stored_key;
+    if (in.status() != QDataStream::Ok || stored_key != key)
+    {
+      return false;
+    }
+    quint32 groups_count = 0;
+    in >> groups_count;
+    for (quint32 i = 0; i < groups_count && in.status() == QDataStream::Ok; i++)
+    {
+      QString name;
+      Attributes attributes;
+      in >> name;
+      ReadAttributes(in, attributes);
+      groups.push_back({ name, std::move(attributes) });
+    }
+    if (!ReadSeries(in, numeric, false) || !ReadSeries(in, scatter_xy, false) ||
+        !ReadSeries(in, strings, true))
+    {
+      return false;
+    }
+  }
+  for (const auto* headers : { &numeric, &scatter_xy, &strings })
+  {
+    for (const auto& series : *headers)
+    {
+      const bool is_string = (headers == &strings);
+      // the first check prevents overflows in ColumnsSize()
+      if (series.size > columns_size || series.offset > columns_size ||
+          ColumnsSize(series, is_string) > columns_size - series.offset)
+      {
+        return false;
+      }
+    }
+  }
+
+  for (const auto& [name, attributes] : groups)
+  {
+    auto group = data.getOrCreateGroup(name.toStdString());
+    for (const auto& [id, value] : attributes)
+    {
+      group->attributes()[id] = value;
+    }
+  }
+
+  auto load_columns = [&](PlotDataBase<double, double>& series,
+                          const SeriesHeader& header) {
+    series.attributes() = header.attributes;
+    const auto* x = reinterpret_cast<const double*>(columns + header.offset);
+    series.pushBackBatch(x, x + header.size, header.size);
+  };
+  for (const auto& header : numeric)
+  {
+    load_columns(data.getOrCreateNumeric(header.name.toStdString(),
+                                         GetGroup(data, header.group)),
+                 header);
+  }
+  for (const auto& header : scatter_xy)
+  {
+    load_columns(data.getOrCreateScatterXY(header.name.toStdString(),
+                                           GetGroup(data, header.group)),
+                 header);
+  }
+  for (const auto& header : strings)
+  {
+    auto& series = data.getOrCreateStringSeries(header.name.toStdString(),
+                                                GetGroup(data, header.group));
+    series.attributes() = header.attributes;
+    const auto* x = reinterpret_cast<const double*>(columns + header.offset);
+    const auto* indices = reinterpret_cast<const uint32_t*>(x + header.size);
+    for (quint64 i = 0; i < header.size; i++)
+    {
+      if (indices[i] < header.dictionary.size())
+      {
+        const auto& str = header.dictionary[indices[i]];
+        series.pushBack({ x[i], StringRef(str.constData(), size_t(str.size())) });
+      }
+    }
+  }
+
+  // used by removeOldFiles() to keep the most recent files
+  file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+  return true;
+}
+
+void SessionCache::removeOldFiles()
+{
+  QDir dir(directory());
+  const auto files =
+      dir.entryInfoList({ "*.pjcache" }, QDir::Files, QDir::Time);  // newest first
+  const qint64 max_bytes = qint64(MAX_TOTAL_MB) * 1024 * 1024;
+  qint64 total_bytes = 0;
+  for (int i = 0; i < files.size(); i++)
+  {
+    total_bytes += files[i].size();
+    if (i >= MAX_FILES || total_bytes > max_bytes)
+    {
+      QFile::remove(files[i].absoluteFilePath());
+    }
+  }
+}
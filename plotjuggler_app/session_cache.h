@@ -0,0 +1,85 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef SESSION_CACHE_H
+#define SESSION_CACHE_H
+
+#include <functional>
+#include <QString>
+#include <QDomElement>
+#include "PlotJuggler/plotdata.h"
+
+/**
+ * @brief Cache of the data parsed by the DataLoaders.
+ *
+ * After a file is parsed, the resulting PlotDataMapRef is written in a columnar
+ * format (timestamps and values stored as contiguous arrays) in the cache
+ * directory of the application. When the same file is opened again with the same
+ * plugin configuration (reload, or a layout with data), the cache is memory-mapped
+ * and the columns are copied directly into the series, without parsing.
+ *
+ * The key identifies the file (path, size and modification time), the plugin,
+ * its version and its configuration: when any of them changes, the cache is not
+ * used.
+ *
+ * The files are not compressed (16 bytes per point): only the most recently used
+ * ones are kept, up to MAX_FILES and MAX_TOTAL_MB.
+ */
+class SessionCache
+{
+public:
+  enum
+  {
+    // only the most recently used files are kept
+    MAX_FILES = 8,
+    MAX_TOTAL_MB = 2048,
+    // smaller files are parsed quickly enough, they are not worth caching
+    MIN_FILE_SIZE_MB = 16
+  };
+
+  /// Receives the fraction of the data written, in [0, 1].
+  /// Return false to cancel the writing.
+  using ProgressCallback = std::function<bool(double)>;
+
+  /**
+   * @param plugin_version  see pluginVersion(). A new build of the plugin may
+   * parse the same file differently.
+   */
+  static QString key(const QString& filename, const QString& plugin_name,
+                     const QString& plugin_version, const QDomElement& plugin_config);
+
+  /// Version of the application and size and modification time of the library
+  /// of the plugin (empty if it is unknown).
+  static QString pluginVersion(const QString& plugin_file);
+
+  /**
+   * @brief Write the data in the cache. It can be called from a worker thread,
+   * as long as data is not modified in the meantime.
+   *
+   * @return false if the data can not be cached (user_defined or blobs series,
+   * larger than MAX_TOTAL_MB), if the file could not be written or if the
+   * writing was cancelled by progress.
+   */
+  static bool save(const QString& key, const PJ::PlotDataMapRef& data,
+                   const ProgressCallback& progress = {});
+
+  /**
+   * @brief Read the data from the cache. The series are added to data.
+   *
+   * @return false if there is no valid cache for this key. In that case,
+   * data is not modified.
+   */
+  static bool load(const QString& key, PJ::PlotDataMapRef& data);
+
+  static QString directory();
+
+private:
+  static QString filePath(const QString& key);
+
+  static void removeOldFiles();
+};
+
+#endif  // SESSION_CACHE_H
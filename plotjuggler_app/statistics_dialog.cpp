@@ -7,6 +7,7 @@
 #include "statistics_dialog.h"
 #include "ui_statistics_dialog.h"
 #include <QTableWidgetItem>
+#include <QLocale>
 #include "qwt_text.h"
 
 StatisticsDialog::StatisticsDialog(PlotWidget* parent)
@@ -43,38 +44,51 @@ void StatisticsDialog::update(PJ::Range range)
   for (const auto& info : _parent->curveList())
   {
     Statistics stat;
-    const auto ts = info.curve->data();
+    const auto series = dynamic_cast<QwtSeriesWrapper*>(info.curve->data());
+    const PlotDataXY* data = series->plotData();
 
-    bool first = true;
+    const bool filter_x = calcVisibleRange() && _parent->isXYPlot();
+    size_t first = 0;
+    size_t last = data->size();
 
-    for (size_t i = 0; i < ts->size(); i++)
+    if (calcVisibleRange() && !_parent->isXYPlot())
     {
-      const auto p = ts->sample(i);
-      if (calcVisibleRange())
+      // timeseries are sorted: find the visible interval with a binary search.
+      // Remember that the canvas coordinates do not include the time offset.
+      auto ts = dynamic_cast<QwtTimeseries*>(series);
+      const double offset = ts ? ts->timeOffset() : 0.0;
+      first = data->columns().lowerBound(range.min + offset);
+      last = data->columns().upperBound(range.max + offset);
+    }
+
+    bool first_value = true;
+
+    // iterate over contiguous arrays of X and Y values
+    auto calcStatistics = [&](const double* x, const double* y, size_t count) {
+      for (size_t i = 0; i < count; i++)
       {
-        if (p.x() < range.min)
+        if (filter_x && (x[i] < range.min || x[i] > range.max))
         {
           continue;
         }
-        if (p.x() > range.max)
+        stat.count++;
+        if (first_value)
         {
-          break;
+          stat.min = y[i];
+          stat.max = y[i];
+          first_value = false;
         }
+        else
+        {
+          stat.min = std::min(stat.min, y[i]);
+          stat.max = std::max(stat.max, y[i]);
+        }
+        stat.mean_tot += y[i];
       }
-      stat.count++;
-      if (first)
-      {
-        stat.min = p.y();
-        stat.max = p.y();
-        first = false;
-      }
-      else
-      {
-        stat.min = std::min(stat.min, p.y());
-        stat.max = std::max(stat.max, p.y());
-      }
-      stat.mean_tot += p.y();
-    }
+    };
+    data->columns().forEachSpan(first, last, calcStatistics);
+    stat.memory = data->memoryUsage();
+
     statistics[info.curve->title().text()] = stat;
   }
 
@@ -84,13 +98,14 @@ void StatisticsDialog::update(PJ::Range range)
   {
     const auto& stat = it.second;
 
-    std::array<QString, 5> row_values;
+    std::array<QString, 6> row_values;
     row_values[0] = it.first;
     row_values[1] = QString::number(stat.count);
     row_values[2] = QString::number(stat.min, 'f');
     row_values[3] = QString::number(stat.max, 'f');
     double mean = stat.mean_tot / double(stat.count);
     row_values[4] = QString::number(mean, 'f');
+    row_values[5] = QLocale().formattedDataSize(stat.memory);
 
     for (size_t col = 0; col < row_values.size(); col++)
     {
@@ -23,6 +23,7 @@ struct Statistics
   double min = 0;
   double max = 0;
   double mean_tot = 0;
+  size_t memory = 0;  // bytes used by the series
 };
 
 class StatisticsDialog : public QDialog
@@ -6,6 +6,7 @@
 
 #include "utils.h"
 #include <QDebug>
+#include <limits>
 
 MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
                      bool remove_older)
@@ -20,14 +21,15 @@ MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
       const std::string& plot_name = source_plot.plotName();
 
       auto dest_plot_it = destination_series.find(ID);
-      if (dest_plot_it == destination_series.end())
+      const bool is_new = (dest_plot_it == destination_series.end());
+      if (is_new)
       {
         ret.added_curves.push_back(ID);
 
         PlotGroup::Ptr group;
         if (source_plot.group())
         {
-          destination.getOrCreateGroup(source_plot.group()->name());
+          group = destination.getOrCreateGroup(source_plot.group()->name());
         }
         dest_plot_it = destination_series
                            .emplace(std::piecewise_construct, std::forward_as_tuple(ID),
@@ -78,26 +80,27 @@ MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
         ret.data_pushed = true;
       }
 
-      if constexpr (std::is_same_v<PlotData, decltype(source_plot)> ||
-                    std::is_same_v<StringSeries, decltype(source_plot)> ||
-                    std::is_same_v<PlotDataAny, decltype(source_plot)>)
+      using SeriesT = std::decay_t<decltype(source_plot)>;
+      if constexpr (std::is_same_v<PlotData, SeriesT> ||
+                    std::is_same_v<StringSeries, SeriesT> ||
+                    std::is_same_v<PlotDataAny, SeriesT> ||
+                    std::is_same_v<BlobSeries, SeriesT>)
       {
+        // a series without limit (streamers, batches of DetachData) must not
+        // overwrite the maximum range chosen by the user in the destination.
         double max_range_x = source_plot.maximumRangeX();
-        destination_plot.setMaximumRangeX(max_range_x);
-      }
-
-      if (destination_plot.size() == 0)
-      {
-        std::swap(destination_plot, source_plot);
-      }
-      else
-      {
-        for (size_t i = 0; i < source_plot.size(); i++)
+        if (is_new || max_range_x < std::numeric_limits<double>::max())
         {
-          destination_plot.pushBack(source_plot.at(i));
+          destination_plot.setMaximumRangeX(max_range_x);
         }
-        source_plot.clear();
       }
+      if constexpr (std::is_same_v<BlobSeries, SeriesT>)
+      {
+        destination_plot.setTypeName(source_plot.typeName());
+      }
+
+      // move entire chunks, unless the points overlap with the existing ones
+      destination_plot.splice(source_plot);
     }
   };
 
@@ -106,6 +109,69 @@ MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
   moveDataImpl(source.strings, destination.strings);
   moveDataImpl(source.scatter_xy, destination.scatter_xy);
   moveDataImpl(source.user_defined, destination.user_defined);
+  moveDataImpl(source.blobs, destination.blobs);
 
   return ret;
 }
+
+void DetachData(PlotDataMapRef& source, PlotDataMapRef& batch)
+{
+  auto detachImpl = [&](auto& source_series, auto& batch_series) {
+    // forget the series removed from source
+    if (batch_series.size() > source_series.size())
+    {
+      for (auto it = batch_series.begin(); it != batch_series.end();)
+      {
+        it = source_series.count(it->first) ? std::next(it) : batch_series.erase(it);
+      }
+    }
+
+    for (auto& [ID, source_plot] : source_series)
+    {
+      auto batch_plot_it = batch_series.find(ID);
+      if (batch_plot_it == batch_series.end())
+      {
+        batch_plot_it = batch_series
+                            .emplace(std::piecewise_construct, std::forward_as_tuple(ID),
+                                     std::forward_as_tuple(source_plot.plotName(),
+                                                           PlotGroup::Ptr()))
+                            .first;
+      }
+      auto& batch_plot = batch_plot_it->second;
+
+      batch_plot.attributes() = source_plot.attributes();
+      if (source_plot.group())
+      {
+        auto group = batch_plot.group();
+        if (!group || group->name() != source_plot.group()->name())
+        {
+          group = batch.getOrCreateGroup(source_plot.group()->name());
+          batch_plot.changeGroup(group);
+        }
+        group->attributes() = source_plot.group()->attributes();
+      }
+
+      using SeriesT = std::decay_t<decltype(source_plot)>;
+      if constexpr (!std::is_same_v<PlotDataXY, SeriesT>)
+      {
+        batch_plot.setMaximumRangeX(source_plot.maximumRangeX());
+      }
+      if constexpr (std::is_same_v<BlobSeries, SeriesT>)
+      {
+        batch_plot.setTypeName(source_plot.typeName());
+      }
+
+      // the points of the batch have been already consumed by MoveData()
+      if (source_plot.size() > 0)
+      {
+        batch_plot.swapPoints(source_plot);
+      }
+    }
+  };
+
+  detachImpl(source.numeric, batch.numeric);
+  detachImpl(source.strings, batch.strings);
+  detachImpl(source.scatter_xy, batch.scatter_xy);
+  detachImpl(source.user_defined, batch.user_defined);
+  detachImpl(source.blobs, batch.blobs);
+}
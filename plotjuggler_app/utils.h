@@ -51,4 +51,15 @@ struct MoveDataRet
 MoveDataRet MoveData(PlotDataMapRef& source, PlotDataMapRef& destination,
                      bool remove_older);
 
+/**
+ * @brief Take the points received so far by a DataStreamer, leaving its series
+ * empty, but with their name, group and attributes.
+ *
+ * The points are exchanged in O(1) per series, without copying them: call it
+ * while holding DataStreamer::mutex() and merge the batch with MoveData() after
+ * releasing it, not to block the threads that receive the data.
+ * The same batch should be reused, to avoid creating its series each time.
+ */
+void DetachData(PlotDataMapRef& source, PlotDataMapRef& batch);
+
 #endif  // UTILS_H
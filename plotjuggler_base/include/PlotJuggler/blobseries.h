@@ -0,0 +1,249 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PJ_BLOBSERIES_H
+#define PJ_BLOBSERIES_H
+
+#include "PlotJuggler/timeseries.h"
+#include <deque>
+#include <memory>
+#include <cstring>
+#include <stdexcept>
+
+namespace PJ
+{
+/**
+ * @brief Non-owning reference to a binary payload.
+ * When pushed into a BlobSeries, the payload is copied; the references
+ * returned by BlobSeries point to its internal storage.
+ */
+struct BlobRef
+{
+  const uint8_t* data = nullptr;
+  uint32_t size = 0;
+  uint32_t page = 0;  // used internally by BlobSeries
+
+  BlobRef() = default;
+
+  BlobRef(const void* ptr, uint32_t length)
+    : data(static_cast<const uint8_t*>(ptr)), size(length)
+  {
+  }
+};
+
+/**
+ * @brief Series of binary payloads (images, point clouds, serialized messages,
+ * etc.), all of the same type.
+ *
+ * Unlike PlotDataAny, that allocates a std::any for each sample, the payloads
+ * are copied one after the other into large pages of memory. Accessing them is
+ * zero-copy and, when old samples are removed, the memory is released one page
+ * at a time.
+ */
+class BlobSeries : public TimeseriesBase<BlobRef>
+{
+public:
+  enum
+  {
+    PAGE_SIZE = 1024 * 1024
+  };
+
+  BlobSeries(const std::string& name, PlotGroup::Ptr group)
+    : TimeseriesBase<BlobRef>(name, group)
+  {
+  }
+
+  BlobSeries(const BlobSeries& other) = delete;
+  BlobSeries(BlobSeries&& other) = default;
+
+  BlobSeries& operator=(const BlobSeries& other) = delete;
+  BlobSeries& operator=(BlobSeries&& other) = default;
+
+  /// Type of the payloads, for instance "sensor_msgs/Image".
+  const std::string& typeName() const
+  {
+    return _type_name;
+  }
+
+  void setTypeName(const std::string& type_name)
+  {
+    _type_name = type_name;
+  }
+
+  /// See PlotDataBase::swapPoints(). The payloads are exchanged too, therefore
+  /// other must be a BlobSeries.
+  void swapPoints(PlotDataBase<double, BlobRef>& other) override
+  {
+    auto other_blobs = dynamic_cast<BlobSeries*>(&other);
+    if (!other_blobs)
+    {
+      throw std::runtime_error("BlobSeries::swapPoints : other is not a BlobSeries");
+    }
+    TimeseriesBase<BlobRef>::swapPoints(other);
+    std::swap(_pages, other_blobs->_pages);
+    std::swap(_first_page, other_blobs->_first_page);
+  }
+
+  /// See PlotDataBase::clonePoints(). The payloads are copied into the pages
+  /// of this series, because the ones of other might be released at any time.
+  void clonePoints(const PlotDataBase<double, BlobRef>& other) override
+  {
+    if (&other == this)
+    {
+      return;
+    }
+    clear();
+    for (size_t i = 0; i < other.size(); i++)
+    {
+      pushBack(other.at(i));
+    }
+  }
+
+  void clear() override
+  {
+    _pages.clear();
+    _first_page = 0;
+    TimeseriesBase<BlobRef>::clear();
+  }
+
+  void pushBack(const Point& p) override
+  {
+    auto temp = p;
+    pushBack(std::move(temp));
+  }
+
+  void pushBack(Point&& p) override
+  {
+    if (std::isinf(p.x) || std::isnan(p.x))
+    {
+      return;
+    }
+    TimeseriesBase<BlobRef>::pushBack({ p.x, store(p.y) });
+  }
+
+  void insert(Iterator it, Point&& p) override
+  {
+    if (std::isinf(p.x) || std::isnan(p.x))
+    {
+      return;
+    }
+    TimeseriesBase<BlobRef>::insert(it, { p.x, store(p.y) });
+  }
+
+  /// The payloads are copied, unless this series is empty.
+  void splice(PlotDataBase<double, BlobRef>& other) override
+  {
+    auto other_blobs = dynamic_cast<BlobSeries*>(&other);
+    if (other_blobs && size() == 0)
+    {
+      clear();
+      swapPoints(*other_blobs);
+      trimRange();
+      return;
+    }
+    for (size_t i = 0; i < other.size(); i++)
+    {
+      pushBack(other.at(i));
+    }
+    other.clear();
+  }
+
+  void popFront() override
+  {
+    const uint32_t page = front().y.page;
+    TimeseriesBase<BlobRef>::popFront();
+    release(page);
+  }
+
+  size_t popFrontChunk() override
+  {
+    const size_t payload = payloadCapacity();
+    const size_t released = TimeseriesBase<BlobRef>::popFrontChunk();
+    return released + (payload - payloadCapacity());
+  }
+
+  size_t memoryUsage() const override
+  {
+    return TimeseriesBase<BlobRef>::memoryUsage() + payloadCapacity();
+  }
+
+  /// Memory used by the payloads.
+  size_t payloadCapacity() const
+  {
+    size_t total = 0;
+    for (const auto& page : _pages)
+    {
+      total += page.capacity;
+    }
+    return total;
+  }
+
+private:
+  static constexpr uint32_t NO_PAGE = ~uint32_t(0);
+
+  struct Page
+  {
+    std::unique_ptr<uint8_t[]> data;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t count = 0;  // samples that reference this page
+  };
+
+  std::string _type_name;
+  std::deque<Page> _pages;
+  uint32_t _first_page = 0;  // id of _pages.front()
+
+  // copy the payload at the end of the last page
+  BlobRef store(const BlobRef& payload)
+  {
+    if (payload.size == 0)
+    {
+      BlobRef empty;
+      empty.page = NO_PAGE;
+      return empty;
+    }
+    if (_pages.empty() || _pages.back().used + payload.size > _pages.back().capacity)
+    {
+      Page page;
+      page.capacity = std::max<size_t>(PAGE_SIZE, payload.size);
+      page.data.reset(new uint8_t[page.capacity]);
+      _pages.push_back(std::move(page));
+    }
+    auto& page = _pages.back();
+    uint8_t* dst = page.data.get() + page.used;
+    std::memcpy(dst, payload.data, payload.size);
+    page.used += payload.size;
+    page.count++;
+
+    BlobRef stored(dst, payload.size);
+    stored.page = _first_page + static_cast<uint32_t>(_pages.size() - 1);
+    return stored;
+  }
+
+  void release(uint32_t page_id)
+  {
+    if (page_id == NO_PAGE)
+    {
+      return;
+    }
+    _pages[page_id - _first_page].count--;
+    while (!_pages.empty() && _pages.front().count == 0)
+    {
+      if (_pages.size() == 1)
+      {
+        // keep the memory of the last page, it can be reused
+        _pages.front().used = 0;
+        break;
+      }
+      _pages.pop_front();
+      _first_page++;
+    }
+  }
+};
+
+}  // namespace PJ
+
+#endif  // PJ_BLOBSERIES_H
@@ -0,0 +1,492 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PJ_CHUNK_CODEC_H
+#define PJ_CHUNK_CODEC_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace PJ
+{
+/**
+ * Lossless compression of a block of samples, inspired by the Gorilla paper
+ * (Facebook's time series database).
+ *
+ * - timestamps: delta-of-delta of their binary representation. Timestamps are
+ *   usually (almost) uniform, therefore most of them are stored in a single bit.
+ * - values: XOR with the previous value, storing only the meaningful bits.
+ *   Slowly changing signals need few bits per sample. Values that are all
+ *   integers (flags, enums, counters) or all float32 are stored instead with
+ *   the minimum number of bits, if smaller. See CompressValues().
+ *
+ * Both are exact, because they work on the 64 bits representation of the doubles.
+ */
+class BitWriter
+{
+public:
+  BitWriter(std::vector<uint64_t>& out) : _out(out)
+  {
+    _out.clear();
+  }
+
+  /// Write the lowest "bits" bits of value (1 <= bits <= 64).
+  void write(uint64_t value, unsigned bits)
+  {
+    if (bits < 64)
+    {
+      value &= (uint64_t(1) << bits) - 1;
+    }
+    if (_used == 64)
+    {
+      _out.push_back(0);
+      _used = 0;
+    }
+    const unsigned available = 64 - _used;
+    if (bits <= available)
+    {
+      _out.back() |= value << (available - bits);
+      _used += bits;
+    }
+    else
+    {
+      const unsigned remaining = bits - available;
+      _out.back() |= value >> remaining;
+      _out.push_back(value << (64 - remaining));
+      _used = remaining;
+    }
+  }
+
+private:
+  std::vector<uint64_t>& _out;
+  unsigned _used = 64;  // bits used in _out.back()
+};
+
+class BitReader
+{
+public:
+  BitReader(const uint64_t* data) : _data(data)
+  {
+  }
+
+  /// Read "bits" bits (1 <= bits <= 64).
+  uint64_t read(unsigned bits)
+  {
+    const unsigned available = 64 - _pos;
+    const uint64_t current = (_data[0] << _pos) >> _pos;
+    if (bits < available)
+    {
+      _pos += bits;
+      return current >> (available - bits);
+    }
+    _data++;
+    _pos = bits - available;
+    if (_pos == 0)
+    {
+      return current;
+    }
+    return (current << _pos) | (_data[0] >> (64 - _pos));
+  }
+
+private:
+  const uint64_t* _data;
+  unsigned _pos = 0;  // bits already read in _data[0]
+};
+
+namespace Codec
+{
+inline uint64_t ToBits(double value)
+{
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline double FromBits(uint64_t bits)
+{
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// value must not be 0
+inline unsigned LeadingZeros(uint64_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return 63 - index;
+#else
+  return __builtin_clzll(value);
+#endif
+}
+
+// value must not be 0
+inline unsigned TrailingZeros(uint64_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return index;
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+inline bool FitsInBits(int64_t value, unsigned bits)
+{
+  const int64_t limit = int64_t(1) << (bits - 1);
+  return value >= -limit && value < limit;
+}
+
+inline int64_t SignExtend(uint64_t value, unsigned bits)
+{
+  return static_cast<int64_t>(value << (64 - bits)) >> (64 - bits);
+}
+
+// number of bits used by delta-of-delta, after a prefix of N "1"
+static constexpr unsigned DOD_BITS[] = { 7, 9, 12, 32, 64 };
+
+inline void EncodeTimestamps(const double* x, size_t count, BitWriter& writer)
+{
+  uint64_t prev = ToBits(x[0]);
+  uint64_t prev_delta = 0;
+  writer.write(prev, 64);
+  for (size_t i = 1; i < count; i++)
+  {
+    const uint64_t current = ToBits(x[i]);
+    const uint64_t delta = current - prev;
+    const int64_t dod = static_cast<int64_t>(delta - prev_delta);
+    if (dod == 0)
+    {
+      writer.write(0, 1);
+    }
+    else
+    {
+      unsigned prefix = 0;
+      while (DOD_BITS[prefix] < 64 && !FitsInBits(dod, DOD_BITS[prefix]))
+      {
+        prefix++;
+      }
+      // prefix "1...10", but the last one doesn't need the final "0"
+      const bool is_last = (DOD_BITS[prefix] == 64);
+      const unsigned prefix_bits = prefix + (is_last ? 1 : 2);
+      const uint64_t prefix_code = is_last ? ((uint64_t(1) << prefix_bits) - 1) :
+                                             ((uint64_t(1) << prefix_bits) - 2);
+      writer.write(prefix_code, prefix_bits);
+      writer.write(static_cast<uint64_t>(dod), DOD_BITS[prefix]);
+    }
+    prev = current;
+    prev_delta = delta;
+  }
+}
+
+inline void DecodeTimestamps(BitReader& reader, size_t count, double* x)
+{
+  uint64_t prev = reader.read(64);
+  uint64_t prev_delta = 0;
+  x[0] = FromBits(prev);
+  for (size_t i = 1; i < count; i++)
+  {
+    uint64_t dod = 0;
+    if (reader.read(1) == 1)
+    {
+      unsigned prefix = 0;
+      while (DOD_BITS[prefix] < 64 && reader.read(1) == 1)
+      {
+        prefix++;
+      }
+      const unsigned bits = DOD_BITS[prefix];
+      dod = reader.read(bits);
+      if (bits < 64)
+      {
+        dod = static_cast<uint64_t>(SignExtend(dod, bits));
+      }
+    }
+    prev_delta += dod;
+    prev += prev_delta;
+    x[i] = FromBits(prev);
+  }
+}
+
+inline void EncodeValues(const double* y, size_t count, BitWriter& writer)
+{
+  uint64_t prev = ToBits(y[0]);
+  unsigned prev_leading = 64;  // no previous window
+  unsigned prev_trailing = 0;
+  writer.write(prev, 64);
+  for (size_t i = 1; i < count; i++)
+  {
+    const uint64_t current = ToBits(y[i]);
+    const uint64_t xored = current ^ prev;
+    prev = current;
+    if (xored == 0)
+    {
+      writer.write(0, 1);
+      continue;
+    }
+    unsigned leading = LeadingZeros(xored);
+    const unsigned trailing = TrailingZeros(xored);
+    leading = (leading > 31) ? 31 : leading;
+
+    if (prev_leading < 64 && leading >= prev_leading && trailing >= prev_trailing)
+    {
+      // the meaningful bits fit in the previous window
+      writer.write(0b10, 2);
+      writer.write(xored >> prev_trailing, 64 - prev_leading - prev_trailing);
+    }
+    else
+    {
+      const unsigned meaningful = 64 - leading - trailing;
+      writer.write(0b11, 2);
+      writer.write(leading, 5);
+      writer.write(meaningful - 1, 6);
+      writer.write(xored >> trailing, meaningful);
+      prev_leading = leading;
+      prev_trailing = trailing;
+    }
+  }
+}
+
+inline void DecodeValues(BitReader& reader, size_t count, double* y)
+{
+  uint64_t prev = reader.read(64);
+  unsigned leading = 0;
+  unsigned trailing = 0;
+  y[0] = FromBits(prev);
+  for (size_t i = 1; i < count; i++)
+  {
+    if (reader.read(1) == 1)
+    {
+      if (reader.read(1) == 1)
+      {
+        leading = reader.read(5);
+        const unsigned meaningful = reader.read(6) + 1;
+        trailing = 64 - leading - meaningful;
+      }
+      prev ^= reader.read(64 - leading - trailing) << trailing;
+    }
+    y[i] = FromBits(prev);
+  }
+}
+
+// first word of a values stream
+enum ValuesEncoding : uint64_t
+{
+  XOR_VALUES = 0,
+  PACKED_INTEGERS = 1,  // (value - min), with a fixed number of bits
+  FLOAT32_VALUES = 2
+};
+
+// true if all the values are integers that an int64 represents exactly
+inline bool AllIntegers(const double* y, size_t count, int64_t& min, int64_t& max)
+{
+  constexpr double LIMIT = 9007199254740992.0;  // 2^53
+  min = std::numeric_limits<int64_t>::max();
+  max = std::numeric_limits<int64_t>::lowest();
+  for (size_t i = 0; i < count; i++)
+  {
+    const double value = y[i];
+    // NaN fails the first check; -0.0 would become +0.0
+    if (!(std::abs(value) <= LIMIT) || value != std::floor(value) ||
+        (value == 0 && std::signbit(value)))
+    {
+      return false;
+    }
+    const auto integer = static_cast<int64_t>(value);
+    min = std::min(min, integer);
+    max = std::max(max, integer);
+  }
+  return true;
+}
+
+// true if all the values are converted to float and back without changes
+inline bool AllFloats(const double* y, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    const double value = y[i];
+    if (std::isfinite(value) && std::abs(value) > FLT_MAX)
+    {
+      return false;
+    }
+    if (ToBits(double(static_cast<float>(value))) != ToBits(value))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline unsigned BitsNeeded(uint64_t value)
+{
+  return (value == 0) ? 0 : 64 - LeadingZeros(value);
+}
+
+inline uint32_t FloatToBits(float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float FloatFromBits(uint32_t bits)
+{
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  // namespace Codec
+
+/// Timestamp at the given index of a uniform timebase (see DetectTimebase).
+inline double UniformTimestamp(double x0, double dt, size_t index)
+{
+  return x0 + double(index) * dt;
+}
+
+/**
+ * Timestamps and values are compressed in separate streams, because the same
+ * timestamps are often shared by many series (see TimestampsPool).
+ * count must be greater than 0.
+ */
+inline void CompressTimestamps(const double* x, size_t count, std::vector<uint64_t>& out)
+{
+  BitWriter writer(out);
+  Codec::EncodeTimestamps(x, count, writer);
+  // the reader might look at the word after the last one
+  out.push_back(0);
+  out.shrink_to_fit();
+}
+
+inline void DecompressTimestamps(const std::vector<uint64_t>& in, size_t count,
+                                 double* x)
+{
+  BitReader reader(in.data());
+  Codec::DecodeTimestamps(reader, count, x);
+}
+
+/**
+ * Values are all converted to double by the parsers, but many of them are
+ * actually booleans, small integers or float32: in that case, the smallest
+ * among the XOR encoding and a fixed-width encoding is used.
+ */
+inline void CompressValues(const double* y, size_t count, std::vector<uint64_t>& out)
+{
+  using namespace Codec;
+  {
+    BitWriter writer(out);
+    writer.write(XOR_VALUES, 64);
+    EncodeValues(y, count, writer);
+  }
+
+  int64_t min = 0;
+  int64_t max = 0;
+  if (AllIntegers(y, count, min, max))
+  {
+    const unsigned bits = BitsNeeded(static_cast<uint64_t>(max - min));
+    if (2 + (count * bits + 63) / 64 < out.size())
+    {
+      BitWriter writer(out);
+      writer.write(PACKED_INTEGERS | (uint64_t(bits) << 8), 64);
+      writer.write(static_cast<uint64_t>(min), 64);
+      for (size_t i = 0; bits > 0 && i < count; i++)
+      {
+        writer.write(static_cast<uint64_t>(static_cast<int64_t>(y[i]) - min), bits);
+      }
+    }
+  }
+  else if (1 + (count + 1) / 2 < out.size() && AllFloats(y, count))
+  {
+    BitWriter writer(out);
+    writer.write(FLOAT32_VALUES, 64);
+    for (size_t i = 0; i < count; i++)
+    {
+      writer.write(FloatToBits(static_cast<float>(y[i])), 32);
+    }
+  }
+  out.push_back(0);
+  out.shrink_to_fit();
+}
+
+/// The stream can be stored anywhere (see SpillFile), not only in a vector.
+inline void DecompressValues(const uint64_t* in, size_t count, double* y)
+{
+  using namespace Codec;
+  BitReader reader(in);
+  const uint64_t header = reader.read(64);
+  switch (header & 0xFF)
+  {
+    case PACKED_INTEGERS: {
+      const unsigned bits = unsigned(header >> 8);
+      const auto min = static_cast<int64_t>(reader.read(64));
+      for (size_t i = 0; i < count; i++)
+      {
+        const uint64_t offset = (bits > 0) ? reader.read(bits) : 0;
+        y[i] = double(min + static_cast<int64_t>(offset));
+      }
+      break;
+    }
+    case FLOAT32_VALUES: {
+      for (size_t i = 0; i < count; i++)
+      {
+        y[i] = FloatFromBits(static_cast<uint32_t>(reader.read(32)));
+      }
+      break;
+    }
+    default:
+      DecodeValues(reader, count, y);
+  }
+}
+
+inline void DecompressValues(const std::vector<uint64_t>& in, size_t count, double* y)
+{
+  DecompressValues(in.data(), count, y);
+}
+
+/**
+ * @brief Check if the timestamps are exactly x[i] = x0 + i * dt (with dt > 0).
+ * In that case they don't need to be stored at all.
+ */
+inline bool DetectTimebase(const double* x, size_t count, double& x0, double& dt)
+{
+  if (count < 2)
+  {
+    return false;
+  }
+  x0 = x[0];
+  dt = (x[count - 1] - x[0]) / double(count - 1);
+  if (!(dt > 0))
+  {
+    return false;
+  }
+  bool uniform = true;
+  for (size_t i = 0; i < count; i++)
+  {
+    uniform &= (x[i] == UniformTimestamp(x0, dt, i));
+  }
+  return uniform;
+}
+
+/// The first timestamp is stored as is, at the beginning of the timestamps stream.
+inline double CompressedFrontX(const std::vector<uint64_t>& in)
+{
+  return Codec::FromBits(in[0]);
+}
+
+}  // namespace PJ
+
+#endif  // PJ_CHUNK_CODEC_H
@@ -0,0 +1,1093 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PJ_CHUNKED_COLUMNS_H
+#define PJ_CHUNKED_COLUMNS_H
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <limits>
+#include <deque>
+#include <array>
+#include <cmath>
+#include "PlotJuggler/minmax_pyramid.h"
+#include "PlotJuggler/chunk_codec.h"
+#include "PlotJuggler/timestamps_pool.h"
+#include "PlotJuggler/spill_file.h"
+
+namespace PJ
+{
+/**
+ * @brief Storage engine of PlotDataBase.
+ *
+ * Samples are stored as two separate columns (x and y), split into chunks of
+ * CHUNK_SIZE elements. Inside a chunk, values are contiguous in memory, so that
+ * scans over a range of samples can be done over plain arrays of doubles.
+ *
+ * Every chunk, but the last one, is always full. Elements removed with
+ * pop_front() are not erased immediately from the first chunk: we just move
+ * the offset of the first valid element and release the chunk once it is empty.
+ *
+ * Chunks are stored in a circular array and released chunks keep their memory
+ * in a pool (see reserve()), therefore, when data is pushed and popped
+ * continuously (streaming), the storage behaves like a ring buffer and doesn't
+ * allocate any memory.
+ *
+ * Elements pushed with push_back_sorted() that are older than the last one are
+ * staged in a reorder buffer and merged all together, with a single sort-merge,
+ * at the next access. Therefore the cost of the out-of-order elements is
+ * O(k log k) plus the size of the tail that must be merged, instead of O(n)
+ * each.
+ *
+ * When both TypeX and Value are double, full chunks that are not used are
+ * compressed (see chunk_codec.h), keeping only HOT_CHUNKS of them uncompressed.
+ * The compressed timestamps are stored in the TimestampsPool, therefore series
+ * that are sampled together (fields of the same message) share them.
+ * - read-only access to a compressed chunk decodes it into a small cache of
+ *   DECODED_CHUNKS entries, therefore references to its elements are valid only
+ *   until DECODED_CHUNKS other compressed chunks are accessed.
+ * - read-write access decompresses the chunk in place; it will be compressed
+ *   again later by compressColdChunks().
+ * - if the timestamps of a chunk are exactly x0 + i * dt (fixed-rate sources),
+ *   only x0 and dt are stored and lowerBound()/upperBound() don't need to
+ *   decode the chunk.
+ * - if the SpillFile is enabled, the compressed values are moved to disk and
+ *   paged back in by the operating system when the chunk is decoded.
+ *
+ * lowerBound() and upperBound() use an interpolation search, that is O(1) when
+ * the sample rate is (almost) constant, with a binary search as fallback.
+ *
+ * When Value is arithmetic, a MinMaxPyramid of the y column is updated
+ * incrementally, to get the range of any interval with rangeY() in O(log n).
+ */
+template <typename TypeX, typename Value>
+class ChunkedColumns
+{
+public:
+  enum
+  {
+    CHUNK_SIZE = 1024,
+    HOT_CHUNKS = 8,
+    DECODED_CHUNKS = 8
+  };
+
+  static constexpr bool COMPRESSIBLE =
+      std::is_same_v<TypeX, double> && std::is_same_v<Value, double>;
+
+  struct Chunk
+  {
+    std::vector<TypeX> x;
+    std::vector<Value> y;
+    std::vector<uint64_t> packed;  // values, not empty if the chunk is compressed
+    SpillFile::Stream spilled;     // values, if moved to the SpillFile instead
+    TimestampsPool::Stream packed_x;  // timestamps, shared with other series
+
+    // if the timestamps of a compressed chunk are uniform, they are not stored
+    // at all: x[i] = x0 + i * dt
+    bool uniform = false;
+    TypeX x0 = {};
+    TypeX dt = {};
+  };
+
+  size_t size() const
+  {
+    mergeLate();
+    return _size;
+  }
+
+  bool empty() const
+  {
+    // the reorder buffer is never used when _size is 0
+    return _size == 0;
+  }
+
+  const TypeX& x(size_t index) const
+  {
+    mergeLate();
+    const size_t pos = index + _front_offset;
+    return readChunk(pos / CHUNK_SIZE).x[pos % CHUNK_SIZE];
+  }
+
+  const Value& y(size_t index) const
+  {
+    mergeLate();
+    const size_t pos = index + _front_offset;
+    return readChunk(pos / CHUNK_SIZE).y[pos % CHUNK_SIZE];
+  }
+
+  /**
+   * @brief Overwrite an existing element. This is the only way to modify a
+   * sample in place: a compressed chunk is decompressed only here, while x() and
+   * y() read it through the cache of decoded chunks.
+   */
+  void set(size_t index, const TypeX& x, Value y)
+  {
+    mergeLate();
+    const size_t pos = index + _front_offset;
+    if constexpr (std::is_arithmetic_v<Value>)
+    {
+      _pyramid.setDirty(firstPosition() + index);
+    }
+    auto& target = writeChunk(pos / CHUNK_SIZE);
+    target.x[pos % CHUNK_SIZE] = x;
+    target.y[pos % CHUNK_SIZE] = std::move(y);
+  }
+
+  /// Number of elements that can be stored without allocating memory.
+  size_t capacity() const
+  {
+    return (_num_chunks + _pool.size()) * CHUNK_SIZE - _front_offset;
+  }
+
+  /**
+   * @brief Preallocate the memory to store (at least) capacity elements.
+   * This memory is not released by pop_front() or clear(), until reserve()
+   * is called again with a smaller value.
+   */
+  void reserve(size_t capacity)
+  {
+    // one more chunk, because the first one is usually partially used
+    _reserved_chunks = (capacity == 0) ? 0 : (capacity + CHUNK_SIZE - 1) / CHUNK_SIZE + 1;
+    growRing(_reserved_chunks);
+    while (_num_chunks + _pool.size() > std::max(_reserved_chunks, _num_chunks + 1) &&
+           !_pool.empty())
+    {
+      _released_bytes += ChunkBytes(_pool.back());
+      _pool.pop_back();
+    }
+    _pool.reserve(_reserved_chunks);
+    while (_num_chunks + _pool.size() < _reserved_chunks)
+    {
+      _pool.emplace_back();
+      _pool.back().x.reserve(CHUNK_SIZE);
+      _pool.back().y.reserve(CHUNK_SIZE);
+    }
+  }
+
+  void clear()
+  {
+    while (_num_chunks > 0)
+    {
+      releaseFrontChunk();
+    }
+    _head = 0;
+    _front_offset = 0;
+    _popped_chunks = 0;
+    _size = 0;
+    _late.clear();
+    _hot_chunks.clear();
+    _decoded_id.fill(NO_CHUNK);
+    _pyramid.clear();
+  }
+
+  /**
+   * @brief Compress the full chunks that were used less recently, keeping
+   * at most hot_chunks of them uncompressed. It is called automatically when
+   * the data grows, but it should be called periodically also when the data is
+   * only read. References to the elements are invalidated.
+   *
+   * Memory preallocated with reserve() is never compressed.
+   */
+  void compressColdChunks(size_t hot_chunks = HOT_CHUNKS)
+  {
+    if constexpr (COMPRESSIBLE)
+    {
+      if (_reserved_chunks > 0)
+      {
+        _hot_chunks.clear();
+        return;
+      }
+      while (_hot_chunks.size() > hot_chunks)
+      {
+        const size_t id = _hot_chunks.front();
+        _hot_chunks.pop_front();
+        // the chunk might be removed, modified or already compressed.
+        // Never compress the last one, that is still growing.
+        if (id < _popped_chunks || id + 1 >= _popped_chunks + _num_chunks)
+        {
+          continue;
+        }
+        auto& target = chunk(id - _popped_chunks);
+        if (!isPacked(target) && target.x.size() == CHUNK_SIZE)
+        {
+          pack(target);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Memory allocated by the storage, in bytes, including the released
+   * chunks kept in the pool. The timestamps shared with other series (see
+   * TimestampsPool) are divided equally among them. Data moved to the SpillFile
+   * is not included.
+   */
+  size_t memoryUsage() const
+  {
+    size_t bytes = sizeof(*this) + _ring.capacity() * sizeof(Chunk) +
+                   _pool.capacity() * sizeof(Chunk) +
+                   _late.capacity() * sizeof(std::pair<TypeX, Value>) +
+                   _hot_chunks.size() * sizeof(size_t) + _pyramid.memoryUsage();
+    for (size_t i = 0; i < _num_chunks; i++)
+    {
+      bytes += ChunkBytes(chunk(i));
+    }
+    for (const auto& released : _pool)
+    {
+      bytes += ChunkBytes(released);
+    }
+    for (const auto& decoded : _decoded)
+    {
+      bytes += ChunkBytes(decoded);
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief Total memory released so far by the storage, in bytes. The difference
+   * between two calls is the memory released in between, without the cost of
+   * memoryUsage().
+   */
+  size_t releasedBytes() const
+  {
+    return _released_bytes;
+  }
+
+  /// Release the memory preallocated by reserve() and the chunks kept for reuse.
+  void shrinkToFit()
+  {
+    _reserved_chunks = 0;
+    for (const auto& released : _pool)
+    {
+      _released_bytes += ChunkBytes(released);
+    }
+    _pool.clear();
+  }
+
+  /// Number of chunks that contain elements.
+  size_t chunksCount() const
+  {
+    mergeLate();
+    return _num_chunks;
+  }
+
+  /// Number of elements that must be removed with pop_front() to release the
+  /// first chunk.
+  size_t frontChunkSize() const
+  {
+    mergeLate();
+    return std::min<size_t>(_size, CHUNK_SIZE - _front_offset);
+  }
+
+  /// Number of chunks currently compressed.
+  size_t compressedChunks() const
+  {
+    size_t count = 0;
+    for (size_t i = 0; i < _num_chunks; i++)
+    {
+      count += isPacked(chunk(i)) ? 1 : 0;
+    }
+    return count;
+  }
+
+  void push_back(const TypeX& x, Value&& y)
+  {
+    if (_num_chunks == 0 || chunk(_num_chunks - 1).x.size() == CHUNK_SIZE)
+    {
+      appendChunk();
+    }
+    auto& last = chunk(_num_chunks - 1);
+    last.x.push_back(x);
+    last.y.push_back(std::move(y));
+    _size++;
+    if constexpr (std::is_arithmetic_v<Value>)
+    {
+      _pyramid.push(firstPosition() + _size - 1, last.y.back());
+    }
+  }
+
+  /// Append count elements. The MinMaxPyramid is updated lazily by rangeY().
+  void append(const TypeX* x, const Value* y, size_t count)
+  {
+    while (count > 0)
+    {
+      if (_num_chunks == 0 || chunk(_num_chunks - 1).x.size() == CHUNK_SIZE)
+      {
+        appendChunk();
+      }
+      auto& last = chunk(_num_chunks - 1);
+      const size_t n = std::min<size_t>(count, CHUNK_SIZE - last.x.size());
+      last.x.insert(last.x.end(), x, x + n);
+      last.y.insert(last.y.end(), y, y + n);
+      _size += n;
+      x += n;
+      y += n;
+      count -= n;
+    }
+  }
+
+  /**
+   * @brief Move all the elements of other at the end of this storage, leaving
+   * other empty. It doesn't check the order of the x column.
+   *
+   * When the last chunk of this storage is full (or there are no chunks at all),
+   * the chunks of other are moved as they are, compressed ones included, without
+   * copying their elements. Otherwise, they are appended span by span.
+   * The MinMaxPyramid is updated lazily by rangeY().
+   */
+  void splice(ChunkedColumns& other)
+  {
+    mergeLate();
+    other.mergeLate();
+    if (other._size == 0)
+    {
+      return;
+    }
+    const bool aligned =
+        (_front_offset + _size) % CHUNK_SIZE == 0 && other._front_offset == 0;
+    if (!aligned)
+    {
+      other.forEachSpan(0, other._size, [this](const TypeX* x, const Value* y,
+                                               size_t count) { append(x, y, count); });
+      other.clear();
+      return;
+    }
+
+    growRing(_num_chunks + other._num_chunks);
+    for (size_t i = 0; i < other._num_chunks; i++)
+    {
+      chunk(_num_chunks) = std::move(other.chunk(i));
+      _num_chunks++;
+      if constexpr (COMPRESSIBLE)
+      {
+        // the previous chunk is full, as in appendChunk()
+        if (_num_chunks > 1 && _reserved_chunks == 0)
+        {
+          _hot_chunks.push_back(_popped_chunks + _num_chunks - 2);
+        }
+      }
+    }
+    _size += other._size;
+    // the chunks have been moved: only reset other
+    other._num_chunks = 0;
+    other.clear();
+
+    if constexpr (COMPRESSIBLE)
+    {
+      if (_hot_chunks.size() > 2 * HOT_CHUNKS)
+      {
+        compressColdChunks();
+      }
+    }
+  }
+
+  /**
+   * @brief Append count elements, keeping the x column sorted.
+   * If the block is not sorted, or older than the last element, the elements
+   * are added one by one with push_back_sorted().
+   *
+   * @return false if at least one element was staged.
+   */
+  bool append_sorted(const TypeX* x, const Value* y, size_t count)
+  {
+    if (count == 0)
+    {
+      return true;
+    }
+    bool sorted = (_size == 0 || !(x[0] < lastX()));
+    // and-reduction without branches, easy to vectorize for the compiler
+    for (size_t i = 1; i < count; i++)
+    {
+      sorted &= !(x[i] < x[i - 1]);
+    }
+    if (sorted)
+    {
+      append(x, y, count);
+      return true;
+    }
+    bool all_appended = true;
+    for (size_t i = 0; i < count; i++)
+    {
+      Value value = y[i];
+      all_appended &= push_back_sorted(x[i], std::move(value));
+    }
+    return all_appended;
+  }
+
+  /**
+   * @brief Append an element, keeping the x column sorted.
+   * If x is smaller than the last element, it is staged and merged later.
+   *
+   * @return false if the element was staged.
+   */
+  bool push_back_sorted(const TypeX& x, Value&& y)
+  {
+    if (_size > 0 && x < lastX())
+    {
+      _late.emplace_back(x, std::move(y));
+      return false;
+    }
+    push_back(x, std::move(y));
+    return true;
+  }
+
+  void pop_front()
+  {
+    mergeLate();
+    if constexpr (!std::is_trivially_destructible_v<Value>)
+    {
+      // release heavy payloads (std::any, etc.) without waiting for the whole chunk
+      chunk(0).y[_front_offset] = Value();
+    }
+    _front_offset++;
+    _size--;
+
+    if (_size == 0)
+    {
+      clear();
+    }
+    else if (_front_offset == CHUNK_SIZE)
+    {
+      releaseFrontChunk();
+      _front_offset = 0;
+      _popped_chunks++;
+      _pyramid.popUntil(firstPosition());
+    }
+  }
+
+  /// Insert an element at position index, shifting the following ones.
+  void insert(size_t index, const TypeX& x, Value&& y)
+  {
+    mergeLate();
+    if (index == _size)
+    {
+      push_back(x, std::move(y));
+      return;
+    }
+    if (index == 0 && _front_offset > 0)
+    {
+      // reuse one of the slots released by pop_front()
+      _front_offset--;
+      _size++;
+      set(0, x, std::move(y));
+      return;
+    }
+
+    if (chunk(_num_chunks - 1).x.size() == CHUNK_SIZE)
+    {
+      appendChunk();
+    }
+    const size_t pos = index + _front_offset;
+    const size_t chunk_index = pos / CHUNK_SIZE;
+    _pyramid.invalidate(firstPosition() + index);
+
+    // keep the invariant "all chunks but the last are full": make room in the
+    // destination chunk, moving the last element of each chunk to the next one.
+    for (size_t i = _num_chunks - 1; i > chunk_index; i--)
+    {
+      auto& prev = writeChunk(i - 1);
+      auto& next = writeChunk(i);
+      next.x.insert(next.x.begin(), prev.x.back());
+      next.y.insert(next.y.begin(), std::move(prev.y.back()));
+      prev.x.pop_back();
+      prev.y.pop_back();
+    }
+    auto& dest = writeChunk(chunk_index);
+    dest.x.insert(dest.x.begin() + (pos % CHUNK_SIZE), x);
+    dest.y.insert(dest.y.begin() + (pos % CHUNK_SIZE), std::move(y));
+    _size++;
+  }
+
+  /**
+   * @brief Call func(const TypeX* x, const Value* y, size_t count) once for each
+   * contiguous block of memory in the index range [first, last).
+   */
+  template <typename Func>
+  void forEachSpan(size_t first, size_t last, Func&& func) const
+  {
+    mergeLate();
+    last = std::min(last, _size);
+    while (first < last)
+    {
+      const size_t pos = first + _front_offset;
+      const auto& span = readChunk(pos / CHUNK_SIZE);
+      const size_t offset = pos % CHUNK_SIZE;
+      const size_t count = std::min(last - first, span.x.size() - offset);
+      func(span.x.data() + offset, span.y.data() + offset, count);
+      first += count;
+    }
+  }
+
+  /// Index of the first element with x >= value. Requires x to be sorted.
+  size_t lowerBound(const TypeX& value) const
+  {
+    mergeLate();
+    return bound(value, [](const TypeX& a, const TypeX& b) { return a < b; });
+  }
+
+  /// Index of the first element with x > value. Requires x to be sorted.
+  size_t upperBound(const TypeX& value) const
+  {
+    mergeLate();
+    return bound(value, [](const TypeX& a, const TypeX& b) { return !(b < a); });
+  }
+
+  /**
+   * @brief Same as lowerBound(), but the search starts from hint, usually the
+   * result of the previous query: a galloping search over the first element of
+   * each chunk costs O(log d), where d is the number of chunks between hint and
+   * the result. Like lowerBound(), compressed chunks are not decoded to find the
+   * chunk, and chunks with uniform timestamps are not decoded at all.
+   * Monotonic queries (tracker, playback) are amortized O(1).
+   */
+  size_t lowerBound(const TypeX& value, size_t hint) const
+  {
+    mergeLate();
+    if (_size == 0)
+    {
+      return 0;
+    }
+    auto less = [](const TypeX& a, const TypeX& b) { return a < b; };
+
+    // find chunks lo < hi such that the result is in lo, i.e. the last chunk
+    // whose first element is less than value (or 0).
+    size_t lo = (std::min(hint, _size - 1) + _front_offset) / CHUNK_SIZE;
+    size_t hi = lo;
+    if (less(frontX(lo), value))
+    {
+      for (size_t step = 1;; step *= 2)
+      {
+        hi = lo + step;
+        if (hi >= _num_chunks)
+        {
+          hi = _num_chunks;
+          break;
+        }
+        if (!less(frontX(hi), value))
+        {
+          break;
+        }
+        lo = hi;
+      }
+    }
+    else
+    {
+      for (size_t step = 1; lo > 0; step *= 2)
+      {
+        hi = lo;
+        lo = (lo > step) ? lo - step : 0;
+        if (less(frontX(lo), value))
+        {
+          break;
+        }
+      }
+    }
+    while (hi - lo > 1)
+    {
+      const size_t mid = (lo + hi) / 2;
+      if (less(frontX(mid), value))
+      {
+        lo = mid;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    return searchInChunk(lo, value, less);
+  }
+
+  /// Range of the y values in the interval of indices [first, last).
+  Range rangeY(size_t first, size_t last) const
+  {
+    static_assert(std::is_arithmetic_v<Value>, "rangeY requires an arithmetic Value");
+    mergeLate();
+    auto scan = [this](size_t first_pos, size_t last_pos) {
+      Range range = { std::numeric_limits<double>::max(),
+                      std::numeric_limits<double>::lowest() };
+      forEachSpan(first_pos - firstPosition(), last_pos - firstPosition(),
+                  [&range](const TypeX*, const Value* y, size_t count) {
+                    UpdateMinMax(y, count, range);
+                  });
+      return range;
+    };
+    _pyramid.update(firstPosition(), firstPosition() + _size, scan);
+    return _pyramid.query(firstPosition() + first, firstPosition() + last, scan);
+  }
+
+  // plain loop over a contiguous array, easy to vectorize for the compiler
+  template <typename T>
+  static void UpdateMinMax(const T* values, size_t count, Range& range)
+  {
+    double min = range.min;
+    double max = range.max;
+    for (size_t i = 0; i < count; i++)
+    {
+      min = (values[i] < min) ? values[i] : min;
+      max = (values[i] > max) ? values[i] : max;
+    }
+    range.min = min;
+    range.max = max;
+  }
+
+private:
+  std::vector<Chunk> _ring;  // circular array of chunks, starting at _head
+  size_t _head = 0;
+  size_t _num_chunks = 0;
+  std::vector<Chunk> _pool;  // released chunks, that still own their memory
+  size_t _reserved_chunks = 0;
+  size_t _front_offset = 0;
+  size_t _popped_chunks = 0;
+  size_t _size = 0;
+  std::vector<std::pair<TypeX, Value>> _late;  // reorder buffer
+  std::deque<size_t> _hot_chunks;  // absolute id of the uncompressed full chunks
+  size_t _released_bytes = 0;
+
+  static constexpr size_t NO_CHUNK = std::numeric_limits<size_t>::max();
+  mutable std::array<Chunk, DECODED_CHUNKS> _decoded;
+  mutable std::array<size_t, DECODED_CHUNKS> _decoded_id = makeDecodedIds();
+  mutable size_t _decoded_next = 0;
+  mutable MinMaxPyramid _pyramid;
+
+  // position of the first element, that keeps growing when elements are
+  // removed from the front. Used as index in the MinMaxPyramid.
+  size_t firstPosition() const
+  {
+    return _popped_chunks * CHUNK_SIZE + _front_offset;
+  }
+
+  const Chunk& chunk(size_t index) const
+  {
+    size_t slot = _head + index;
+    return _ring[slot < _ring.size() ? slot : slot - _ring.size()];
+  }
+
+  Chunk& chunk(size_t index)
+  {
+    size_t slot = _head + index;
+    return _ring[slot < _ring.size() ? slot : slot - _ring.size()];
+  }
+
+  static std::array<size_t, DECODED_CHUNKS> makeDecodedIds()
+  {
+    std::array<size_t, DECODED_CHUNKS> ids;
+    ids.fill(NO_CHUNK);
+    return ids;
+  }
+
+  static bool isPacked(const Chunk& target)
+  {
+    return !target.packed.empty() || target.spilled;
+  }
+
+  static bool isEmpty(const Chunk& target)
+  {
+    return target.x.empty() && !isPacked(target);
+  }
+
+  TypeX frontX(size_t index) const
+  {
+    const auto& target = chunk(index);
+    if constexpr (COMPRESSIBLE)
+    {
+      if (isPacked(target))
+      {
+        // no need to decode the entire chunk
+        return target.uniform ? target.x0 : CompressedFrontX(*target.packed_x);
+      }
+    }
+    return target.x.front();
+  }
+
+  void pack(Chunk& target)
+  {
+    if constexpr (COMPRESSIBLE)
+    {
+      target.uniform = DetectTimebase(target.x.data(), CHUNK_SIZE, target.x0, target.dt);
+      if (!target.uniform)
+      {
+        std::vector<uint64_t> stream;
+        CompressTimestamps(target.x.data(), CHUNK_SIZE, stream);
+        target.packed_x = TimestampsPool::global().intern(std::move(stream));
+      }
+      CompressValues(target.y.data(), CHUNK_SIZE, target.packed);
+      target.spilled =
+          SpillFile::global().store(target.packed.data(), target.packed.size());
+      if (target.spilled)
+      {
+        std::vector<uint64_t>().swap(target.packed);
+      }
+      std::vector<TypeX>().swap(target.x);
+      std::vector<Value>().swap(target.y);
+    }
+  }
+
+  // decode a compressed chunk into dst (that can be the chunk itself)
+  static void unpack(const Chunk& src, Chunk& dst)
+  {
+    if constexpr (COMPRESSIBLE)
+    {
+      dst.x.resize(CHUNK_SIZE);
+      dst.y.resize(CHUNK_SIZE);
+      if (src.uniform)
+      {
+        for (size_t i = 0; i < CHUNK_SIZE; i++)
+        {
+          dst.x[i] = UniformTimestamp(src.x0, src.dt, i);
+        }
+      }
+      else
+      {
+        DecompressTimestamps(*src.packed_x, CHUNK_SIZE, dst.x.data());
+      }
+      DecompressValues(src.spilled ? src.spilled.get() : src.packed.data(), CHUNK_SIZE,
+                       dst.y.data());
+    }
+  }
+
+  // read-only access: compressed chunks are decoded in the cache
+  const Chunk& readChunk(size_t index) const
+  {
+    const auto& target = chunk(index);
+    if constexpr (COMPRESSIBLE)
+    {
+      if (isPacked(target))
+      {
+        const size_t id = _popped_chunks + index;
+        for (size_t i = 0; i < DECODED_CHUNKS; i++)
+        {
+          if (_decoded_id[i] == id)
+          {
+            return _decoded[i];
+          }
+        }
+        const size_t slot = _decoded_next;
+        _decoded_next = (_decoded_next + 1) % DECODED_CHUNKS;
+        auto& decoded = _decoded[slot];
+        unpack(target, decoded);
+        _decoded_id[slot] = id;
+        return decoded;
+      }
+    }
+    return target;
+  }
+
+  // read-write access: compressed chunks are decompressed in place
+  Chunk& writeChunk(size_t index)
+  {
+    auto& target = chunk(index);
+    if constexpr (COMPRESSIBLE)
+    {
+      if (isPacked(target))
+      {
+        const size_t id = _popped_chunks + index;
+        unpack(target, target);
+        std::vector<uint64_t>().swap(target.packed);
+        target.spilled.reset();
+        target.packed_x.reset();
+        target.uniform = false;
+        for (size_t i = 0; i < DECODED_CHUNKS; i++)
+        {
+          _decoded_id[i] = (_decoded_id[i] == id) ? NO_CHUNK : _decoded_id[i];
+        }
+        _hot_chunks.push_back(id);
+      }
+    }
+    return target;
+  }
+
+  // make room for (at least) count chunks, keeping their order
+  void growRing(size_t count)
+  {
+    if (count <= _ring.size())
+    {
+      return;
+    }
+    std::vector<Chunk> ring(count);
+    for (size_t i = 0; i < _num_chunks; i++)
+    {
+      ring[i] = std::move(chunk(i));
+    }
+    _ring.swap(ring);
+    _head = 0;
+  }
+
+  void appendChunk()
+  {
+    if (_num_chunks == _ring.size())
+    {
+      growRing(std::max<size_t>(2 * _ring.size(), 4));
+    }
+    auto& last = chunk(_num_chunks);
+    if (!_pool.empty())
+    {
+      last = std::move(_pool.back());
+      _pool.pop_back();
+    }
+    if (_num_chunks > 0)
+    {
+      // the series is already long, skip the incremental growth of the vectors
+      last.x.reserve(CHUNK_SIZE);
+      last.y.reserve(CHUNK_SIZE);
+    }
+    _num_chunks++;
+
+    if constexpr (COMPRESSIBLE)
+    {
+      // the previous chunk is full now
+      if (_num_chunks > 1 && _reserved_chunks == 0)
+      {
+        _hot_chunks.push_back(_popped_chunks + _num_chunks - 2);
+      }
+      if (_hot_chunks.size() > 2 * HOT_CHUNKS)
+      {
+        compressColdChunks();
+      }
+    }
+  }
+
+  static size_t ChunkBytes(const Chunk& target)
+  {
+    size_t bytes = target.x.capacity() * sizeof(TypeX) +
+                   target.y.capacity() * sizeof(Value) +
+                   target.packed.capacity() * sizeof(uint64_t);
+    if (target.packed_x)
+    {
+      bytes += target.packed_x->capacity() * sizeof(uint64_t) /
+               size_t(target.packed_x.use_count());
+    }
+    return bytes;
+  }
+
+  void releaseFrontChunk()
+  {
+    auto& first = chunk(0);
+    _head = (_head + 1 == _ring.size()) ? 0 : _head + 1;
+    _num_chunks--;
+    recycle(first);
+  }
+
+  void releaseBackChunk()
+  {
+    _num_chunks--;
+    recycle(chunk(_num_chunks));
+  }
+
+  // Keep the memory of the released chunk, to avoid reallocating continuously
+  // when data is pushed and popped (streaming). We retain the reserved memory
+  // or, at least, one chunk.
+  void recycle(Chunk& released)
+  {
+    _released_bytes += ChunkBytes(released);
+    released.x.clear();
+    released.y.clear();
+    std::vector<uint64_t>().swap(released.packed);
+    released.spilled.reset();
+    released.packed_x.reset();
+    released.uniform = false;
+    if (_num_chunks + _pool.size() < std::max(_reserved_chunks, _num_chunks + 1))
+    {
+      _pool.push_back(std::move(released));
+      _released_bytes -= ChunkBytes(_pool.back());
+    }
+    released = Chunk();
+  }
+
+  const TypeX& lastX() const
+  {
+    const size_t pos = _size - 1 + _front_offset;
+    return chunk(pos / CHUNK_SIZE).x[pos % CHUNK_SIZE];
+  }
+
+  // The content doesn't change from the point of view of the user, the
+  // reorder buffer is an implementation detail: this is logically const.
+  void mergeLate() const
+  {
+    if (!_late.empty())
+    {
+      const_cast<ChunkedColumns*>(this)->mergeLateImpl();
+    }
+  }
+
+  void mergeLateImpl()
+  {
+    std::stable_sort(_late.begin(), _late.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // move out the tail that overlaps with the staged elements
+    const size_t first = bound(_late.front().first,
+                               [](const TypeX& a, const TypeX& b) { return !(b < a); });
+    std::vector<std::pair<TypeX, Value>> tail;
+    tail.reserve(_size - first);
+    const size_t pos = first + _front_offset;
+    for (size_t c = pos / CHUNK_SIZE; c < _num_chunks; c++)
+    {
+      auto& src = writeChunk(c);
+      const size_t offset = (c == pos / CHUNK_SIZE) ? pos % CHUNK_SIZE : 0;
+      for (size_t i = offset; i < src.x.size(); i++)
+      {
+        tail.emplace_back(src.x[i], std::move(src.y[i]));
+      }
+      src.x.erase(src.x.begin() + offset, src.x.end());
+      src.y.erase(src.y.begin() + offset, src.y.end());
+    }
+    while (_num_chunks > 1 && isEmpty(chunk(_num_chunks - 1)))
+    {
+      releaseBackChunk();
+    }
+    if (_num_chunks > 0)
+    {
+      // the new last chunk will grow again: it can not stay compressed
+      writeChunk(_num_chunks - 1);
+    }
+    _size = first;
+    _pyramid.invalidate(firstPosition() + first);
+
+    // merge. In case of equal x, the elements of the tail were received first
+    std::vector<std::pair<TypeX, Value>> late;
+    std::swap(late, _late);
+    auto it_tail = tail.begin();
+    auto it_late = late.begin();
+    while (it_tail != tail.end() || it_late != late.end())
+    {
+      auto& next = (it_late == late.end() ||
+                    (it_tail != tail.end() && !(it_late->first < it_tail->first))) ?
+                       *(it_tail++) :
+                       *(it_late++);
+      push_back(next.first, std::move(next.second));
+    }
+    // keep the memory of the reorder buffer
+    late.clear();
+    std::swap(late, _late);
+  }
+
+  // search first over the chunks, then inside the contiguous array.
+  // "less(a,b)" returns true if "a" must be skipped when searching for "b".
+  template <typename Compare>
+  size_t bound(const TypeX& value, Compare less) const
+  {
+    if (_size == 0)
+    {
+      return 0;
+    }
+    return searchInChunk(findChunk(value, less), value, less);
+  }
+
+  // search inside the chunk lo, the last one whose first element must be skipped
+  template <typename Compare>
+  size_t searchInChunk(size_t lo, const TypeX& value, Compare less) const
+  {
+    const size_t offset = (lo == 0) ? _front_offset : 0;
+    if constexpr (COMPRESSIBLE)
+    {
+      const auto& target = chunk(lo);
+      if (target.uniform && isPacked(target))
+      {
+        // the timestamps are implicit: no need to decode the chunk
+        auto at = [&](size_t i) { return UniformTimestamp(target.x0, target.dt, i); };
+        return lo * CHUNK_SIZE + searchChunk(offset, CHUNK_SIZE, value, less, at) -
+               _front_offset;
+      }
+    }
+    const auto& found = readChunk(lo);
+    auto at = [&](size_t i) -> const TypeX& { return found.x[i]; };
+    return lo * CHUNK_SIZE + searchChunk(offset, found.x.size(), value, less, at) -
+           _front_offset;
+  }
+
+  // last chunk whose first element must be skipped (or 0)
+  template <typename Compare>
+  size_t findChunk(const TypeX& value, Compare less) const
+  {
+    if constexpr (std::is_arithmetic_v<TypeX>)
+    {
+      if (_num_chunks > 2)
+      {
+        // interpolation: the guess is correct when the sample rate is (almost)
+        // constant, the binary search is the fallback
+        const double first = frontX(0);
+        const double span = double(frontX(_num_chunks - 1)) - first;
+        const double guess = (double(value) - first) / span * double(_num_chunks - 1);
+        if (guess >= 0 && guess < double(_num_chunks))
+        {
+          const size_t index = static_cast<size_t>(guess);
+          if ((index == 0 || less(frontX(index), value)) &&
+              (index + 1 == _num_chunks || !less(frontX(index + 1), value)))
+          {
+            return index;
+          }
+        }
+      }
+    }
+    size_t lo = 0;
+    size_t hi = _num_chunks;
+    while (hi - lo > 1)
+    {
+      const size_t mid = (lo + hi) / 2;
+      if (less(frontX(mid), value))
+      {
+        lo = mid;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // first index in [begin, end) that must not be skipped (or end).
+  // "at(i)" returns the i-th element of the chunk.
+  template <typename Compare, typename Accessor>
+  static size_t searchChunk(size_t begin, size_t end, const TypeX& value, Compare less,
+                            Accessor&& at)
+  {
+    if constexpr (std::is_arithmetic_v<TypeX>)
+    {
+      if (end - begin > 2)
+      {
+        // same as findChunk(). Accept the guess, or its neighbours, if correct
+        const double first = at(begin);
+        const double span = double(at(end - 1)) - first;
+        const double guess =
+            std::ceil((double(value) - first) / span * double(end - 1 - begin));
+        if (guess >= 0 && guess <= double(end - begin))
+        {
+          const size_t index = begin + static_cast<size_t>(guess);
+          const size_t lo = (index > begin) ? index - 1 : begin;
+          const size_t hi = std::min(index + 1, end);
+          for (size_t i = lo; i <= hi; i++)
+          {
+            if ((i == begin || less(at(i - 1), value)) &&
+                (i == end || !less(at(i), value)))
+            {
+              return i;
+            }
+          }
+        }
+      }
+    }
+    while (begin < end)
+    {
+      const size_t mid = (begin + end) / 2;
+      if (less(at(mid), value))
+      {
+        begin = mid + 1;
+      }
+      else
+      {
+        end = mid;
+      }
+    }
+    return begin;
+  }
+};
+
+}  // namespace PJ
+
+#endif  // PJ_CHUNKED_COLUMNS_H
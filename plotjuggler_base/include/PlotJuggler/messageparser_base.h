@@ -127,6 +127,32 @@ protected:
     return _plot_data.getOrCreateStringSeries(key);
   }
 
+  /**
+   * @brief Faster version of getSeries(), to be used when the same series are
+   * updated by every message (typically, one handle per field).
+   * make_key() is invoked, and the series is looked up by name, only if the
+   * handle is not valid; the handle is updated accordingly.
+   */
+  template <typename MakeKey>
+  PlotData& getSeries(NumericHandle& handle, MakeKey&& make_key)
+  {
+    if (!_plot_data.isValid(handle))
+    {
+      handle = _plot_data.getNumericHandle(make_key());
+    }
+    return *handle.series;
+  }
+
+  template <typename MakeKey>
+  StringSeries& getStringSeries(StringSeriesHandle& handle, MakeKey&& make_key)
+  {
+    if (!_plot_data.isValid(handle))
+    {
+      handle = _plot_data.getStringSeriesHandle(make_key());
+    }
+    return *handle.series;
+  }
+
 private:
   bool _clamp_large_arrays = false;
   unsigned _max_array_size = 10000;
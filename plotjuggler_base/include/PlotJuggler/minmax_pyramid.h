@@ -0,0 +1,345 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PJ_MINMAX_PYRAMID_H
+#define PJ_MINMAX_PYRAMID_H
+
+#include <vector>
+#include <limits>
+#include <optional>
+#include <algorithm>
+
+namespace PJ
+{
+struct Range
+{
+  double min;
+  double max;
+};
+
+typedef std::optional<Range> RangeOpt;
+
+/**
+ * @brief Hierarchy of min/max summaries, used to answer the question
+ * "which is the range of the values between position A and B" in O(log n).
+ *
+ * Level 0 stores the min/max of each block of BLOCK_SIZE consecutive samples,
+ * level L+1 the min/max of FANOUT consecutive nodes of level L.
+ *
+ * Positions are "absolute": they keep growing when samples are removed from
+ * the front, therefore the nodes never need to be shifted. The nodes that
+ * are only partially valid (because some of their samples were removed)
+ * are never used by query(), because they can not be fully contained in the
+ * interval of valid samples.
+ *
+ * The class doesn't store the samples itself: the owner must provide a
+ * function scan(first, last) that returns the range of the samples in the
+ * interval of absolute positions [first, last).
+ */
+class MinMaxPyramid
+{
+public:
+  enum
+  {
+    BLOCK_SIZE = 64,
+    FANOUT = 16
+  };
+
+  void clear()
+  {
+    _levels.clear();
+    _dirty_blocks.clear();
+    _valid_end = 0;
+    _stale_tail = false;
+  }
+
+  /// A new sample was appended at position pos.
+  void push(size_t pos, double value)
+  {
+    if (pos != _valid_end || _stale_tail)
+    {
+      // summaries are already invalid from _valid_end: they will be rebuilt
+      return;
+    }
+    _valid_end++;
+
+    size_t index = pos / BLOCK_SIZE;
+    for (auto& level : _levels)
+    {
+      if (level.nodes.empty() || index == level.first + level.nodes.size())
+      {
+        if (level.nodes.empty())
+        {
+          level.first = index;
+        }
+        level.nodes.push_back({ value, value });
+      }
+      else
+      {
+        Merge(level.nodes.back(), { value, value });
+      }
+      index /= FANOUT;
+    }
+    if (_levels.empty())
+    {
+      _levels.emplace_back();
+      _levels[0].first = index;
+      _levels[0].nodes.push_back({ value, value });
+    }
+    growLevels();
+  }
+
+  /**
+   * @brief The samples before position pos were removed.
+   * The obsolete nodes are erased only when they are at least half of the level,
+   * to have an amortized O(1) cost without reallocating the vectors.
+   */
+  void popUntil(size_t pos)
+  {
+    size_t span = BLOCK_SIZE;
+    for (auto& level : _levels)
+    {
+      const size_t obsolete = std::min(pos / span - std::min(pos / span, level.first),
+                                       level.nodes.size());
+      if (obsolete > 0 && 2 * obsolete >= level.nodes.size())
+      {
+        level.nodes.erase(level.nodes.begin(), level.nodes.begin() + obsolete);
+        level.first += obsolete;
+      }
+      span *= FANOUT;
+    }
+  }
+
+  /// All the samples starting from position pos changed (or were shifted).
+  void invalidate(size_t pos)
+  {
+    if (pos < _valid_end)
+    {
+      // the nodes after _valid_end still exist: don't merge new values into them
+      _valid_end = pos;
+      _stale_tail = true;
+    }
+  }
+
+  /// The sample at position pos was modified in place.
+  void setDirty(size_t pos)
+  {
+    const size_t block = pos / BLOCK_SIZE;
+    if (pos < _valid_end && (_dirty_blocks.empty() || _dirty_blocks.back() != block))
+    {
+      _dirty_blocks.push_back(block);
+    }
+  }
+
+  /**
+   * @brief Min/max of the samples in the interval of positions [first, last).
+   * The interval must contain only existing samples and update() must be
+   * called first.
+   *
+   * @param scan  function Range(size_t first, size_t last), used to access the
+   * samples directly.
+   */
+  template <typename ScanFunc>
+  Range query(size_t first, size_t last, ScanFunc&& scan) const
+  {
+    Range out = { std::numeric_limits<double>::max(),
+                  std::numeric_limits<double>::lowest() };
+
+    size_t lo = (first + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    size_t hi = last / BLOCK_SIZE;
+    if (lo >= hi)
+    {
+      Merge(out, scan(first, last));
+      return out;
+    }
+    // partial blocks at the beginning and the end of the interval
+    if (first < lo * BLOCK_SIZE)
+    {
+      Merge(out, scan(first, lo * BLOCK_SIZE));
+    }
+    if (hi * BLOCK_SIZE < last)
+    {
+      Merge(out, scan(hi * BLOCK_SIZE, last));
+    }
+
+    for (size_t L = 0; L < _levels.size() && lo < hi; L++)
+    {
+      const auto& level = _levels[L];
+      const bool is_top = (L + 1 == _levels.size());
+      while (lo < hi && (lo % FANOUT != 0 || is_top))
+      {
+        Merge(out, level.nodes[lo - level.first]);
+        lo++;
+      }
+      while (lo < hi && hi % FANOUT != 0)
+      {
+        hi--;
+        Merge(out, level.nodes[hi - level.first]);
+      }
+      lo /= FANOUT;
+      hi /= FANOUT;
+    }
+    return out;
+  }
+
+  /**
+   * @brief Rebuild the nodes that are not valid anymore.
+   * [begin, end) is the interval of positions of the existing samples.
+   */
+  template <typename ScanFunc>
+  void update(size_t begin, size_t end, ScanFunc&& scan)
+  {
+    if (_valid_end < end)
+    {
+      const size_t start = std::max(_valid_end, begin);
+      if (_levels.empty())
+      {
+        _levels.emplace_back();
+        _levels[0].first = start / BLOCK_SIZE;
+      }
+      size_t index = start / BLOCK_SIZE;
+      for (size_t L = 0; L < _levels.size(); L++)
+      {
+        auto& level = _levels[L];
+        if (level.nodes.empty() || index < level.first)
+        {
+          level.first = index;
+          level.nodes.clear();
+        }
+        level.nodes.resize(index - level.first);
+
+        if (L == 0)
+        {
+          for (size_t n = index; n * BLOCK_SIZE < end; n++)
+          {
+            const size_t first = std::max(n * BLOCK_SIZE, begin);
+            const size_t last = std::min(n * BLOCK_SIZE + BLOCK_SIZE, end);
+            level.nodes.push_back(scan(first, last));
+          }
+        }
+        else
+        {
+          const auto& lower = _levels[L - 1];
+          const size_t last = (lower.first + lower.nodes.size() - 1) / FANOUT;
+          for (size_t n = index; n <= last; n++)
+          {
+            level.nodes.push_back(mergeChildren(L, n));
+          }
+        }
+        index /= FANOUT;
+      }
+      growLevels();
+      _valid_end = end;
+      _stale_tail = false;
+    }
+
+    if (!_dirty_blocks.empty())
+    {
+      std::sort(_dirty_blocks.begin(), _dirty_blocks.end());
+      _dirty_blocks.erase(std::unique(_dirty_blocks.begin(), _dirty_blocks.end()),
+                          _dirty_blocks.end());
+      for (size_t L = 0; L < _levels.size(); L++)
+      {
+        auto& level = _levels[L];
+        for (size_t n : _dirty_blocks)
+        {
+          if (n < level.first || n >= level.first + level.nodes.size())
+          {
+            continue;
+          }
+          if (L == 0)
+          {
+            const size_t first = std::max(n * BLOCK_SIZE, begin);
+            const size_t last = std::min(n * BLOCK_SIZE + BLOCK_SIZE, end);
+            if (first < last)
+            {
+              level.nodes[n - level.first] = scan(first, last);
+            }
+          }
+          else
+          {
+            level.nodes[n - level.first] = mergeChildren(L, n);
+          }
+        }
+        // move to the parents
+        for (auto& n : _dirty_blocks)
+        {
+          n /= FANOUT;
+        }
+        _dirty_blocks.erase(std::unique(_dirty_blocks.begin(), _dirty_blocks.end()),
+                            _dirty_blocks.end());
+      }
+      _dirty_blocks.clear();
+    }
+  }
+
+  /// Memory allocated by the summaries, in bytes.
+  size_t memoryUsage() const
+  {
+    size_t bytes = _levels.capacity() * sizeof(Level) +
+                   _dirty_blocks.capacity() * sizeof(size_t);
+    for (const auto& level : _levels)
+    {
+      bytes += level.nodes.capacity() * sizeof(Range);
+    }
+    return bytes;
+  }
+
+  static void Merge(Range& range, const Range& other)
+  {
+    range.min = std::min(range.min, other.min);
+    range.max = std::max(range.max, other.max);
+  }
+
+private:
+  struct Level
+  {
+    size_t first = 0;  // absolute index of nodes.front()
+    std::vector<Range> nodes;
+  };
+
+  std::vector<Level> _levels;
+  std::vector<size_t> _dirty_blocks;
+  size_t _valid_end = 0;
+  bool _stale_tail = false;
+
+  // add levels on top, until the highest one contains a single node
+  void growLevels()
+  {
+    while (_levels.back().nodes.size() > 1)
+    {
+      const size_t L = _levels.size();
+      _levels.emplace_back();
+      const auto& lower = _levels[L - 1];
+      _levels[L].first = lower.first / FANOUT;
+      const size_t last = (lower.first + lower.nodes.size() - 1) / FANOUT;
+      for (size_t n = _levels[L].first; n <= last; n++)
+      {
+        _levels[L].nodes.push_back(mergeChildren(L, n));
+      }
+    }
+  }
+
+  Range mergeChildren(size_t L, size_t index) const
+  {
+    const auto& lower = _levels[L - 1];
+    Range out = { std::numeric_limits<double>::max(),
+                  std::numeric_limits<double>::lowest() };
+    const size_t first = std::max(index * FANOUT, lower.first);
+    const size_t last =
+        std::min(index * FANOUT + FANOUT, lower.first + lower.nodes.size());
+    for (size_t n = first; n < last; n++)
+    {
+      Merge(out, lower.nodes[n - lower.first]);
+    }
+    return out;
+  }
+
+};
+
+}  // namespace PJ
+
+#endif  // PJ_MINMAX_PYRAMID_H
@@ -10,6 +10,9 @@
 #include "plotdatabase.h"
 #include "timeseries.h"
 #include "stringseries.h"
+#include "blobseries.h"
+#include <unordered_set>
+#include <map>
 
 namespace PJ
 {
@@ -29,6 +32,23 @@ using TimeseriesMap = std::unordered_map<std::string, PlotData>;
 using ScatterXYMap = std::unordered_map<std::string, PlotDataXY>;
 using AnySeriesMap = std::unordered_map<std::string, PlotDataAny>;
 using StringSeriesMap = std::unordered_map<std::string, StringSeries>;
+using BlobSeriesMap = std::unordered_map<std::string, BlobSeries>;
+
+/**
+ * @brief Reference to a series of PlotDataMapRef that can be cached, to skip
+ * the lookup by name (and the creation of the name itself) every time a sample
+ * is added. It is invalidated by PlotDataMapRef::clear() and erase(), but
+ * not if the series are removed directly from the maps.
+ */
+template <typename T>
+struct SeriesHandle
+{
+  T* series = nullptr;
+  uint64_t epoch = 0;
+};
+
+using NumericHandle = SeriesHandle<PlotData>;
+using StringSeriesHandle = SeriesHandle<StringSeries>;
 
 struct PlotDataMapRef
 {
@@ -44,6 +64,10 @@ struct PlotDataMapRef
   /// Series of strings
   StringSeriesMap strings;
 
+  /// Series of binary payloads (images, point clouds, etc.). Prefer them to
+  /// user_defined when the payloads are large or many.
+  BlobSeriesMap blobs;
+
   /**
    * @brief Each series can have (optionally) a group.
    * Groups can have their own properties.
@@ -60,6 +84,8 @@ struct PlotDataMapRef
   StringSeriesMap::iterator addStringSeries(const std::string& name,
                                             PlotGroup::Ptr group = {});
 
+  BlobSeriesMap::iterator addBlobSeries(const std::string& name, PlotGroup::Ptr group = {});
+
   PlotDataXY& getOrCreateScatterXY(const std::string& name, PlotGroup::Ptr group = {});
 
   PlotData& getOrCreateNumeric(const std::string& name, PlotGroup::Ptr group = {});
@@ -69,15 +95,57 @@ struct PlotDataMapRef
 
   PlotDataAny& getOrCreateUserDefined(const std::string& name, PlotGroup::Ptr group = {});
 
+  BlobSeries& getOrCreateBlobSeries(const std::string& name, PlotGroup::Ptr group = {});
+
   PlotGroup::Ptr getOrCreateGroup(const std::string& name);
 
+  /// Same as getOrCreateNumeric(), but returns a handle that can be cached.
+  NumericHandle getNumericHandle(const std::string& name, PlotGroup::Ptr group = {});
+
+  /// Same as getOrCreateStringSeries(), but returns a handle that can be cached.
+  StringSeriesHandle getStringSeriesHandle(const std::string& name,
+                                           PlotGroup::Ptr group = {});
+
+  /// False if the series referenced by the handle might have been removed.
+  template <typename T>
+  bool isValid(const SeriesHandle<T>& handle) const
+  {
+    return handle.series != nullptr && handle.epoch == _epoch;
+  }
+
   std::unordered_set<std::string> getAllNames() const;
 
   void clear();
 
   void setMaximumRangeX(double range);
 
+  /// See TimeseriesBase::setRingBufferMode()
+  void setRingBufferMode(bool enable);
+
+  /// See ChunkedColumns::compressColdChunks()
+  void compressColdChunks();
+
+  /// Memory used by all the series, in bytes. See PlotDataBase::memoryUsage()
+  size_t memoryUsage() const;
+
+  /// Memory used by the series of each group (key "" for the ones without group).
+  std::map<std::string, size_t> memoryUsagePerGroup() const;
+
+  /**
+   * @brief If the series use more than max_bytes, remove their oldest chunks
+   * until the memory is below the budget. The chunks with the oldest samples are
+   * removed first, therefore all the timeseries lose the same interval of time.
+   * The memory preallocated by the ring buffer of those series is released too.
+   *
+   * @return the memory released, in bytes.
+   */
+  size_t enforceMemoryBudget(size_t max_bytes);
+
   bool erase(const std::string& name);
+
+private:
+  // incremented when series are removed, to invalidate the handles
+  uint64_t _epoch = 1;
 };
 
 template <typename Value>
@@ -23,17 +23,10 @@
 #include <any>
 #include <optional>
 #include <QVariant>
+#include "PlotJuggler/chunked_columns.h"
 
 namespace PJ
 {
-struct Range
-{
-  double min;
-  double max;
-};
-
-typedef std::optional<Range> RangeOpt;
-
 // Attributes supported by the GUI.
 enum PlotAttribute
 {
@@ -138,8 +131,187 @@ public:
     ASYNC_BUFFER_CAPACITY = 1024
   };
 
-  typedef typename std::deque<Point>::iterator Iterator;
-  typedef typename std::deque<Point>::const_iterator ConstIterator;
+  using Storage = ChunkedColumns<TypeX, Value>;
+
+  /**
+   * @brief Samples are not stored as Point, but in separate columns.
+   * at(), front(), back() and the iterators return this lightweight reference
+   * instead, that behaves like a Point (members "x" and "y").
+   */
+  class ConstPointRef
+  {
+  public:
+    const TypeX& x;
+    const Value& y;
+    ConstPointRef(const Storage* storage, size_t index)
+      : x(storage->x(index)), y(storage->y(index))
+    {
+    }
+    ConstPointRef(const ConstPointRef& other) = default;
+
+    operator Point() const
+    {
+      return Point(x, y);
+    }
+  };
+
+  /**
+   * @brief Like ConstPointRef, but a Point can be assigned to it.
+   * Reading "x" and "y" never modifies the storage; the assignment is the only
+   * operation that writes (and decompresses) the chunk, see ChunkedColumns::set().
+   */
+  class MutablePointRef : public ConstPointRef
+  {
+  public:
+    MutablePointRef(Storage* storage, size_t index)
+      : ConstPointRef(storage, index), _storage(storage), _index(index)
+    {
+    }
+    MutablePointRef(const MutablePointRef& other) = default;
+
+    const MutablePointRef& operator=(const Point& p) const
+    {
+      _storage->set(_index, p.x, p.y);
+      return *this;
+    }
+
+  private:
+    Storage* _storage;
+    size_t _index;
+  };
+
+  template <typename StorageT, typename Ref>
+  class IteratorT
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = Point;
+    using difference_type = std::ptrdiff_t;
+    using reference = const Ref;
+    using pointer = void;
+
+    IteratorT() = default;
+    IteratorT(StorageT* storage, size_t index) : _storage(storage), _index(index)
+    {
+    }
+
+    reference operator*() const
+    {
+      return Ref(_storage, _index);
+    }
+    reference operator[](difference_type n) const
+    {
+      return *(*this + n);
+    }
+
+    struct ArrowProxy
+    {
+      Ref ref;
+      const Ref* operator->() const
+      {
+        return &ref;
+      }
+    };
+    ArrowProxy operator->() const
+    {
+      return { **this };
+    }
+
+    size_t index() const
+    {
+      return _index;
+    }
+
+    IteratorT& operator++()
+    {
+      _index++;
+      return *this;
+    }
+
+    IteratorT& operator--()
+    {
+      _index--;
+      return *this;
+    }
+
+    IteratorT operator++(int)
+    {
+      auto prev = *this;
+      _index++;
+      return prev;
+    }
+
+    IteratorT operator--(int)
+    {
+      auto prev = *this;
+      _index--;
+      return prev;
+    }
+
+    IteratorT& operator+=(difference_type n)
+    {
+      _index += n;
+      return *this;
+    }
+
+    IteratorT& operator-=(difference_type n)
+    {
+      _index -= n;
+      return *this;
+    }
+
+    IteratorT operator+(difference_type n) const
+    {
+      return IteratorT(_storage, _index + n);
+    }
+
+    IteratorT operator-(difference_type n) const
+    {
+      return IteratorT(_storage, _index - n);
+    }
+
+    difference_type operator-(const IteratorT& other) const
+    {
+      return difference_type(_index) - difference_type(other._index);
+    }
+
+    bool operator==(const IteratorT& other) const
+    {
+      return _index == other._index;
+    }
+
+    bool operator!=(const IteratorT& other) const
+    {
+      return _index != other._index;
+    }
+
+    bool operator<(const IteratorT& other) const
+    {
+      return _index < other._index;
+    }
+
+    bool operator>(const IteratorT& other) const
+    {
+      return _index > other._index;
+    }
+
+    bool operator<=(const IteratorT& other) const
+    {
+      return _index <= other._index;
+    }
+
+    bool operator>=(const IteratorT& other) const
+    {
+      return _index >= other._index;
+    }
+
+  private:
+    StorageT* _storage = nullptr;
+    size_t _index = 0;
+  };
+
+  typedef IteratorT<Storage, MutablePointRef> Iterator;
+  typedef IteratorT<const Storage, ConstPointRef> ConstIterator;
   typedef Value ValueT;
 
   PlotDataBase(const std::string& name, PlotGroup::Ptr group)
@@ -153,13 +325,27 @@ public:
   PlotDataBase& operator=(const PlotDataBase& other) = delete;
   PlotDataBase& operator=(PlotDataBase&& other) = default;
 
-  void clonePoints(const PlotDataBase& other)
+  virtual void clonePoints(const PlotDataBase& other)
   {
     _points = other._points;
     _range_x = other._range_x;
     _range_y = other._range_y;
     _range_x_dirty = other._range_x_dirty;
     _range_y_dirty = other._range_y_dirty;
+    _epoch = std::max(_epoch, other._epoch) + 1;
+  }
+
+  /// Exchange the samples with another series, in O(1).
+  /// Name, group and attributes are not changed.
+  virtual void swapPoints(PlotDataBase& other)
+  {
+    std::swap(_points, other._points);
+    std::swap(_range_x, other._range_x);
+    std::swap(_range_y, other._range_y);
+    std::swap(_range_x_dirty, other._range_x_dirty);
+    std::swap(_range_y_dirty, other._range_y_dirty);
+    _epoch = std::max(_epoch, other._epoch) + 1;
+    other._epoch = _epoch;
   }
 
   virtual ~PlotDataBase() = default;
@@ -189,28 +375,92 @@ public:
     return false;
   }
 
-  const Point& at(size_t index) const
+  /**
+   * @brief Counter incremented every time the samples are added, removed,
+   * swapped or cloned. If two calls return the same value, the series was not
+   * modified in between (values assigned through the non-const at() are not
+   * tracked).
+   */
+  uint64_t modificationEpoch() const
+  {
+    return _epoch;
+  }
+
+  const ConstPointRef at(size_t index) const
   {
-    return _points[index];
+    return ConstPointRef(&_points, index);
   }
 
-  Point& at(size_t index)
+  const MutablePointRef at(size_t index)
   {
-    return _points[index];
+    return MutablePointRef(&_points, index);
   }
 
-  const Point& operator[](size_t index) const
+  const ConstPointRef operator[](size_t index) const
   {
     return at(index);
   }
 
-  Point& operator[](size_t index)
+  const MutablePointRef operator[](size_t index)
   {
     return at(index);
   }
 
+  /// Direct access to the columnar storage, to iterate over contiguous arrays.
+  const Storage& columns() const
+  {
+    return _points;
+  }
+
+  /// See ChunkedColumns::compressColdChunks()
+  void compressColdChunks()
+  {
+    _points.compressColdChunks();
+  }
+
+  /// Memory used by the samples, in bytes. See ChunkedColumns::memoryUsage()
+  virtual size_t memoryUsage() const
+  {
+    return _points.memoryUsage();
+  }
+
+  /**
+   * @brief Remove the oldest samples, until the first chunk of the storage is
+   * released. The last chunk is never removed.
+   *
+   * @return the memory released, in bytes. It is 0 when there was nothing to
+   * remove, or when the chunk is kept for reuse (see shrinkToFit()).
+   */
+  virtual size_t popFrontChunk()
+  {
+    if (_points.chunksCount() < 2)
+    {
+      return 0;
+    }
+    const size_t released = _points.releasedBytes();
+    for (size_t count = _points.frontChunkSize(); count > 0; count--)
+    {
+      popFront();
+    }
+    return _points.releasedBytes() - released;
+  }
+
+  /**
+   * @brief Release the memory preallocated for the ring buffer and the chunks
+   * kept for reuse. See ChunkedColumns::shrinkToFit().
+   *
+   * @return the memory released, in bytes.
+   */
+  size_t shrinkToFit()
+  {
+    const size_t released = _points.releasedBytes();
+    _points.shrinkToFit();
+    return _points.releasedBytes() - released;
+  }
+
   virtual void clear()
   {
+    _epoch++;
     _points.clear();
     _range_x_dirty = true;
     _range_y_dirty = true;
@@ -241,34 +491,34 @@ public:
     return (it == _attributes.end()) ? QVariant() : it->second;
   }
 
-  const Point& front() const
+  const ConstPointRef front() const
   {
-    return _points.front();
+    return at(0);
   }
 
-  const Point& back() const
+  const ConstPointRef back() const
   {
-    return _points.back();
+    return at(_points.size() - 1);
   }
 
   ConstIterator begin() const
   {
-    return _points.begin();
+    return ConstIterator(&_points, 0);
   }
 
   ConstIterator end() const
   {
-    return _points.end();
+    return ConstIterator(&_points, _points.size());
   }
 
   Iterator begin()
   {
-    return _points.begin();
+    return Iterator(&_points, 0);
   }
 
   Iterator end()
   {
-    return _points.end();
+    return Iterator(&_points, _points.size());
   }
 
   // template specialization for types that support compare operator
@@ -284,11 +534,10 @@ public:
       {
         _range_x.min = front().x;
         _range_x.max = _range_x.min;
-        for (const auto& p : _points)
-        {
-          _range_x.min = std::min(_range_x.min, p.x);
-          _range_x.max = std::max(_range_x.max, p.x);
-        }
+        _points.forEachSpan(0, _points.size(),
+                            [this](const TypeX* x, const Value*, size_t count) {
+                              Storage::UpdateMinMax(x, count, _range_x);
+                            });
         _range_x_dirty = false;
       }
       return _range_x;
@@ -296,7 +545,9 @@ public:
     return std::nullopt;
   }
 
-  // template specialization for types that support compare operator
+  // template specialization for types that support compare operator.
+  // When dirty (popFront() removed the min or the max), the range is computed
+  // with the MinMaxPyramid in O(log n), not scanning all the samples again.
   virtual RangeOpt rangeY() const
   {
     if constexpr (std::is_arithmetic_v<Value>)
@@ -307,13 +558,7 @@ public:
       }
       if (_range_y_dirty)
       {
-        _range_y.min = front().y;
-        _range_y.max = _range_y.min;
-        for (const auto& p : _points)
-        {
-          _range_y.min = std::min(_range_y.min, p.y);
-          _range_y.max = std::max(_range_y.max, p.y);
-        }
+        _range_y = _points.rangeY(0, _points.size());
         _range_y_dirty = false;
       }
       return _range_y;
@@ -321,6 +566,21 @@ public:
     return std::nullopt;
   }
 
+  /// Range of the Y values in the interval of indices [first, last).
+  RangeOpt rangeY(size_t first, size_t last) const
+  {
+    if constexpr (std::is_arithmetic_v<Value>)
+    {
+      last = std::min(last, _points.size());
+      if (first >= last)
+      {
+        return std::nullopt;
+      }
+      return _points.rangeY(first, last);
+    }
+    return std::nullopt;
+  }
+
   virtual void pushBack(const Point& p)
   {
     auto temp = p;
@@ -329,51 +589,109 @@ public:
 
   virtual void pushBack(Point&& p)
   {
-    if constexpr (std::is_arithmetic_v<TypeX>)
+    if (acceptPoint(p))
     {
-      if (std::isinf(p.x) || std::isnan(p.x))
-      {
-        return;  // skip
-      }
-      pushUpdateRangeX(p);
+      _epoch++;
+      _points.push_back(p.x, std::move(p.y));
     }
-    if constexpr (std::is_arithmetic_v<Value>)
+  }
+
+  virtual void insert(Iterator it, Point&& p)
+  {
+    if (acceptPoint(p))
     {
-      if (std::isinf(p.y) || std::isnan(p.y))
-      {
-        return;  // skip
-      }
-      pushUpdateRangeY(p);
+      _epoch++;
+      _points.insert(it.index(), p.x, std::move(p.y));
     }
-
-    _points.emplace_back(p);
   }
 
-  virtual void insert(Iterator it, Point&& p)
+  /**
+   * @brief Move all the points of other at the end of this series, leaving it
+   * empty. Entire chunks are moved without copying their points, when possible
+   * (see ChunkedColumns::splice()). The cost doesn't depend on the number of
+   * points.
+   */
+  virtual void splice(PlotDataBase& other)
   {
-    if constexpr (std::is_arithmetic_v<TypeX>)
+    if (other._points.empty())
     {
-      if (std::isinf(p.x) || std::isnan(p.x))
-      {
-        return;  // skip
-      }
-      pushUpdateRangeX(p);
+      return;
     }
-    if constexpr (std::is_arithmetic_v<Value>)
+    _epoch++;
+    if (_points.empty())
     {
-      if (std::isinf(p.y) || std::isnan(p.y))
+      _range_x = other._range_x;
+      _range_y = other._range_y;
+      _range_x_dirty = other._range_x_dirty;
+      _range_y_dirty = other._range_y_dirty;
+    }
+    else
+    {
+      auto merge = [](Range& range, bool& dirty, const Range& added, bool added_dirty) {
+        if (!dirty && !added_dirty)
+        {
+          MinMaxPyramid::Merge(range, added);
+        }
+        else
+        {
+          dirty = true;
+        }
+      };
+      merge(_range_x, _range_x_dirty, other._range_x, other._range_x_dirty);
+      merge(_range_y, _range_y_dirty, other._range_y, other._range_y_dirty);
+    }
+    _points.splice(other._points);
+    other.clear();
+  }
+
+  /**
+   * @brief Append count points at once, much faster than calling pushBack()
+   * for each of them. Points with NaN or Inf values are skipped.
+   *
+   * @param stride_x  distance between two consecutive x values (number of elements).
+   * @param stride_y  distance between two consecutive y values (number of elements).
+   */
+  void pushBackBatch(const TypeX* x, const Value* y, size_t count, size_t stride_x = 1,
+                     size_t stride_y = 1)
+  {
+    static_assert(std::is_arithmetic_v<TypeX> && std::is_arithmetic_v<Value>,
+                  "pushBackBatch requires arithmetic types");
+    // the data is processed in blocks, that are copied only when they must be
+    // filtered (or are not contiguous).
+    constexpr size_t BLOCK_SIZE = 512;
+    _epoch += (count > 0) ? 1 : 0;
+    TypeX block_x[BLOCK_SIZE];
+    Value block_y[BLOCK_SIZE];
+
+    for (size_t first = 0; first < count; first += BLOCK_SIZE)
+    {
+      const size_t n = std::min<size_t>(BLOCK_SIZE, count - first);
+      const TypeX* src_x = x + first * stride_x;
+      const Value* src_y = y + first * stride_y;
+
+      if (stride_x == 1 && stride_y == 1 && AllFinite(src_x, n) && AllFinite(src_y, n))
       {
-        return;  // skip
+        appendBlock(src_x, src_y, n);
+        continue;
+      }
+      size_t valid = 0;
+      for (size_t i = 0; i < n; i++)
+      {
+        block_x[valid] = src_x[i * stride_x];
+        block_y[valid] = src_y[i * stride_y];
+        valid += (IsFinite(block_x[valid]) && IsFinite(block_y[valid])) ? 1 : 0;
+      }
+      if (valid > 0)
+      {
+        appendBlock(block_x, block_y, valid);
       }
-      pushUpdateRangeY(p);
     }
-
-    _points.insert(it, p);
   }
 
   virtual void popFront()
   {
-    const auto& p = _points.front();
+    _epoch++;
+    const auto p = front();
 
     if constexpr (std::is_arithmetic_v<TypeX>)
     {
@@ -396,15 +714,102 @@ public:
 protected:
   std::string _name;
   Attributes _attributes;
-  std::deque<Point> _points;
+  Storage _points;
 
   mutable Range _range_x;
   mutable Range _range_y;
   mutable bool _range_x_dirty;
   mutable bool _range_y_dirty;
+  uint64_t _epoch = 0;
   mutable std::shared_ptr<PlotGroup> _group;
 
   // template specialization for types that support compare operator
+  // Append a block of valid points, used by pushBackBatch().
+  virtual void appendBlock(const TypeX* x, const Value* y, size_t count)
+  {
+    updateRanges(x, y, count);
+    _points.append(x, y, count);
+  }
+
+  // Update the ranges with a block of points, before adding it.
+  void updateRanges(const TypeX* x, const Value* y, size_t count)
+  {
+    if constexpr (std::is_arithmetic_v<TypeX> && std::is_arithmetic_v<Value>)
+    {
+      Range block_x = { std::numeric_limits<double>::max(),
+                        std::numeric_limits<double>::lowest() };
+      Range block_y = block_x;
+      Storage::UpdateMinMax(x, count, block_x);
+      Storage::UpdateMinMax(y, count, block_y);
+      if (_points.empty())
+      {
+        _range_x = block_x;
+        _range_y = block_y;
+        _range_x_dirty = false;
+        _range_y_dirty = false;
+        return;
+      }
+      if (!_range_x_dirty)
+      {
+        MinMaxPyramid::Merge(_range_x, block_x);
+      }
+      if (!_range_y_dirty)
+      {
+        MinMaxPyramid::Merge(_range_y, block_y);
+      }
+    }
+  }
+
+  template <typename T>
+  static bool IsFinite(T value)
+  {
+    if constexpr (std::is_floating_point_v<T>)
+    {
+      return std::isfinite(value);
+    }
+    return true;
+  }
+
+  // (value - value) is NaN only if value is NaN or Inf. The and-reduction
+  // doesn't have branches and it is easy to vectorize for the compiler.
+  template <typename T>
+  static bool AllFinite(const T* values, size_t count)
+  {
+    if constexpr (std::is_floating_point_v<T>)
+    {
+      bool all_finite = true;
+      for (size_t i = 0; i < count; i++)
+      {
+        all_finite &= ((values[i] - values[i]) == T(0));
+      }
+      return all_finite;
+    }
+    return true;
+  }
+
+  // Return false if the point must be skipped (NaN or Inf).
+  // Otherwise, update the ranges, before adding it.
+  bool acceptPoint(const Point& p)
+  {
+    if constexpr (std::is_arithmetic_v<TypeX>)
+    {
+      if (std::isinf(p.x) || std::isnan(p.x))
+      {
+        return false;
+      }
+      pushUpdateRangeX(p);
+    }
+    if constexpr (std::is_arithmetic_v<Value>)
+    {
+      if (std::isinf(p.y) || std::isnan(p.y))
+      {
+        return false;
+      }
+      pushUpdateRangeY(p);
+    }
+    return true;
+  }
+
   virtual void pushUpdateRangeX(const Point& p)
   {
     if constexpr (std::is_arithmetic_v<TypeX>)
@@ -99,6 +99,38 @@ public:
 
   void setAcceptDrops(bool accept);
 
+  /**
+   * @brief Use it when the series received only new samples (streaming): the
+   * next paint keeps the curves painted by the previous one, scrolled by the
+   * shift of the X axis, and draws only the new samples.
+   *
+   * It applies only to the next call of replot().
+   * The curves are painted entirely anyway if the Y axis, the width of the
+   * X range, the size of the canvas or the curves changed.
+   */
+  void allowIncrementalPaint();
+
+  /**
+   * @brief Fraction of the pixel columns used to decimate the curves, in (0, 1].
+   * Lower values make the curves faster to render, but less accurate.
+   * It is applied to the curves added later too.
+   */
+  void setLevelOfDetail(double lod);
+
+  double levelOfDetail() const;
+
+  /// Time spent painting the canvas since the previous call, in nanoseconds.
+  qint64 takePaintTime();
+
+  /**
+   * @brief Compute the polylines of the visible curves of these widgets using a
+   * pool of threads, instead of doing it in the GUI thread when they are painted.
+   *
+   * Call it after replot(), while the data is not modified. Widgets that were
+   * not replotted since they were painted last time are skipped.
+   */
+  static void prepareCurves(const std::vector<PlotWidgetBase*>& widgets);
+
 public slots:
 
   void replot();
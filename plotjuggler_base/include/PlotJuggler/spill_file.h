@@ -0,0 +1,92 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PJ_SPILL_FILE_H
+#define PJ_SPILL_FILE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace PJ
+{
+/**
+ * @brief Storage on disk for the compressed chunks of ChunkedColumns.
+ *
+ * Compressed data is copied into temporary files that are memory-mapped:
+ * the operating system writes them to disk and pages them back in only when
+ * they are accessed, therefore datasets larger than the RAM can be loaded.
+ *
+ * The files are split into segments of SEGMENT_SIZE bytes. A segment is
+ * deleted when all the streams stored in it have been released.
+ * It is thread-safe.
+ */
+class SpillFile
+{
+public:
+  enum
+  {
+    SEGMENT_SIZE = 256 * 1024 * 1024
+  };
+
+  /// Data stored in the file. The space is released with the last reference.
+  using Stream = std::shared_ptr<const uint64_t>;
+
+  /// Storage used by all the instances of PlotData.
+  static SpillFile& global();
+
+  SpillFile();
+
+  ~SpillFile();
+
+  SpillFile(const SpillFile&) = delete;
+  SpillFile& operator=(const SpillFile&) = delete;
+
+  /// Disabled by default. Streams already stored remain valid when disabled.
+  void setEnabled(bool enabled)
+  {
+    _enabled = enabled;
+  }
+
+  bool isEnabled() const
+  {
+    return _enabled;
+  }
+
+  /**
+   * @brief Copy the words into the file.
+   *
+   * @return an empty Stream if disabled or if the file can not be created
+   * (in that case, the data must stay in memory).
+   */
+  Stream store(const uint64_t* words, size_t count);
+
+  /// Bytes stored in the file and not released yet.
+  size_t size() const;
+
+private:
+  struct Segment;
+
+  static constexpr size_t NO_SEGMENT = ~size_t(0);
+
+  std::atomic<bool> _enabled = false;
+
+  mutable std::mutex _mutex;
+  std::vector<std::unique_ptr<Segment>> _segments;  // released ones are nullptr
+  size_t _current = NO_SEGMENT;
+  size_t _stored_bytes = 0;
+
+  bool addSegment();
+
+  void release(size_t segment_id, size_t bytes);
+};
+
+}  // namespace PJ
+
+#endif  // PJ_SPILL_FILE_H
@@ -0,0 +1,339 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PJ_STRING_DICTIONARY_H
+#define PJ_STRING_DICTIONARY_H
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace PJ
+{
+/**
+ * @brief Dictionary of strings, shared by all the StringSeries.
+ *
+ * Status and enum-like strings are repeated in many samples and many series:
+ * each distinct string is stored only once and identified by a 32-bit ID.
+ *
+ * The strings are reference counted: intern() increments the count and
+ * release() decrements it. A string is removed when it is not referenced
+ * anymore, and the memory of the arena is released one block at a time, when
+ * all its strings are removed. Looking up a string that is already in the
+ * dictionary doesn't allocate any memory. It is thread-safe.
+ */
+class StringDictionary
+{
+public:
+  struct Entry
+  {
+    uint32_t id;
+    std::string_view str;
+  };
+
+  static StringDictionary& global();
+
+  /// Return the entry of the string, adding it if needed, and increment its
+  /// reference count. The view remains valid until the string is released.
+  Entry intern(std::string_view str)
+  {
+    const uint64_t hash = std::hash<std::string_view>()(str);
+    {
+      std::shared_lock<std::shared_mutex> lock(_mutex);
+      const uint32_t id = find(str, hash);
+      if (id != NONE)
+      {
+        _counts[id].fetch_add(1, std::memory_order_relaxed);
+        return { id, _strings[id] };
+      }
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    // it might have been added in the meantime by another thread
+    uint32_t id = find(str, hash);
+    if (id == NONE)
+    {
+      id = add(str, hash);
+    }
+    _counts[id].fetch_add(1, std::memory_order_relaxed);
+    return { id, _strings[id] };
+  }
+
+  /// Decrement the reference count of views returned by intern().
+  /// Views that do not belong to the dictionary are ignored.
+  void release(const std::string_view* strings, size_t count)
+  {
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    for (size_t i = 0; i < count; i++)
+    {
+      const auto& str = strings[i];
+      if (str.empty())
+      {
+        continue;
+      }
+      const uint32_t id = find(str, std::hash<std::string_view>()(str));
+      if (id != NONE && _strings[id].data() == str.data() &&
+          _counts[id].fetch_sub(1, std::memory_order_relaxed) == 1)
+      {
+        remove(id);
+      }
+    }
+  }
+
+  void release(std::string_view str)
+  {
+    release(&str, 1);
+  }
+
+  std::string_view get(uint32_t id) const
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _strings[id];
+  }
+
+  /// Number of distinct strings.
+  size_t size() const
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _strings.size() - _free_ids.size();
+  }
+
+  /// Memory used by the dictionary, in bytes.
+  size_t memoryUsage() const
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return sizeof(*this) + _arena_bytes +
+           _strings.capacity() * sizeof(std::string_view) +
+           _hashes.capacity() * sizeof(uint64_t) +
+           _block_of.capacity() * sizeof(uint32_t) +
+           _counts.size() * sizeof(std::atomic<uint32_t>) +
+           _blocks.capacity() * sizeof(Block) + _table.capacity() * sizeof(uint32_t);
+  }
+
+private:
+  static constexpr uint32_t NONE = ~uint32_t(0);
+  // the blocks grow from MIN_BLOCK_SIZE to BLOCK_SIZE: a dictionary with a
+  // handful of strings stays small.
+  static constexpr size_t MIN_BLOCK_SIZE = 1024;
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+  static constexpr size_t MIN_TABLE_SIZE = 64;
+
+  struct Block
+  {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    size_t used = 0;
+    size_t count = 0;  // strings stored in this block
+  };
+
+  mutable std::shared_mutex _mutex;
+
+  std::vector<std::string_view> _strings;  // indexed by ID
+  std::vector<uint64_t> _hashes;           // indexed by ID
+  std::vector<uint32_t> _block_of;         // indexed by ID
+  // indexed by ID. Incremented also under the shared lock; a deque never
+  // moves its elements.
+  std::deque<std::atomic<uint32_t>> _counts;
+  std::vector<uint32_t> _free_ids;
+
+  // open addressing with linear probing. Size is a power of 2
+  std::vector<uint32_t> _table;
+
+  std::vector<Block> _blocks;
+  std::vector<uint32_t> _free_blocks;
+  uint32_t _current_block = NONE;  // where the short strings are added
+  size_t _block_size = 0;
+  size_t _arena_bytes = 0;
+
+  uint32_t find(std::string_view str, uint64_t hash) const
+  {
+    if (_table.empty())
+    {
+      return NONE;
+    }
+    const size_t mask = _table.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+      const uint32_t id = _table[slot];
+      if (id == NONE || (_hashes[id] == hash && _strings[id] == str))
+      {
+        return id;
+      }
+    }
+  }
+
+  uint32_t add(std::string_view str, uint64_t hash)
+  {
+    // keep the load factor below 50%
+    const size_t count = _strings.size() - _free_ids.size();
+    if (2 * (count + 1) > _table.size())
+    {
+      rehash(std::max<size_t>(MIN_TABLE_SIZE, 2 * _table.size()));
+    }
+    uint32_t id = NONE;
+    if (_free_ids.empty())
+    {
+      id = static_cast<uint32_t>(_strings.size());
+      _strings.emplace_back();
+      _hashes.emplace_back();
+      _block_of.emplace_back();
+      _counts.emplace_back(0);
+    }
+    else
+    {
+      id = _free_ids.back();
+      _free_ids.pop_back();
+    }
+    _strings[id] = store(str, _block_of[id]);
+    _hashes[id] = hash;
+    insertSlot(id);
+    return id;
+  }
+
+  void remove(uint32_t id)
+  {
+    eraseSlot(id);
+    const uint32_t block_id = _block_of[id];
+    if (block_id != NONE && --_blocks[block_id].count == 0)
+    {
+      if (block_id == _current_block)
+      {
+        // keep the memory of the current block, it can be reused
+        _blocks[block_id].used = 0;
+      }
+      else
+      {
+        freeBlock(block_id);
+      }
+    }
+    _strings[id] = {};
+    _free_ids.push_back(id);
+  }
+
+  // copy the string into the arena
+  std::string_view store(std::string_view str, uint32_t& block_id)
+  {
+    block_id = NONE;
+    if (str.empty())
+    {
+      return {};
+    }
+    if (str.size() > BLOCK_SIZE / 4)
+    {
+      // large strings get their own block, not to waste the current one
+      block_id = newBlock(str.size());
+    }
+    else
+    {
+      if (_current_block == NONE ||
+          _blocks[_current_block].used + str.size() > _blocks[_current_block].size)
+      {
+        const uint32_t previous = _current_block;
+        _block_size = std::clamp(2 * _block_size, MIN_BLOCK_SIZE, BLOCK_SIZE);
+        _current_block = newBlock(std::max(_block_size, str.size()));
+        if (previous != NONE && _blocks[previous].count == 0)
+        {
+          freeBlock(previous);
+        }
+      }
+      block_id = _current_block;
+    }
+    Block& block = _blocks[block_id];
+    char* dst = block.data.get() + block.used;
+    std::memcpy(dst, str.data(), str.size());
+    block.used += str.size();
+    block.count++;
+    return { dst, str.size() };
+  }
+
+  uint32_t newBlock(size_t size)
+  {
+    uint32_t block_id = NONE;
+    if (_free_blocks.empty())
+    {
+      block_id = static_cast<uint32_t>(_blocks.size());
+      _blocks.emplace_back();
+    }
+    else
+    {
+      block_id = _free_blocks.back();
+      _free_blocks.pop_back();
+    }
+    Block& block = _blocks[block_id];
+    block.data.reset(new char[size]);
+    block.size = size;
+    block.used = 0;
+    block.count = 0;
+    _arena_bytes += size;
+    return block_id;
+  }
+
+  void freeBlock(uint32_t block_id)
+  {
+    Block& block = _blocks[block_id];
+    _arena_bytes -= block.size;
+    block = Block();
+    _free_blocks.push_back(block_id);
+  }
+
+  void insertSlot(uint32_t id)
+  {
+    const size_t mask = _table.size() - 1;
+    size_t slot = _hashes[id] & mask;
+    while (_table[slot] != NONE)
+    {
+      slot = (slot + 1) & mask;
+    }
+    _table[slot] = id;
+  }
+
+  // remove the ID from the table, moving back the following entries of the
+  // probing sequence, instead of leaving a tombstone.
+  void eraseSlot(uint32_t id)
+  {
+    const size_t mask = _table.size() - 1;
+    size_t slot = _hashes[id] & mask;
+    while (_table[slot] != id)
+    {
+      slot = (slot + 1) & mask;
+    }
+    _table[slot] = NONE;
+    for (size_t next = (slot + 1) & mask; _table[next] != NONE; next = (next + 1) & mask)
+    {
+      const size_t home = _hashes[_table[next]] & mask;
+      // the entry can fill the hole only if it is not before its home slot
+      if (((next - home) & mask) >= ((next - slot) & mask))
+      {
+        _table[slot] = _table[next];
+        _table[next] = NONE;
+        slot = next;
+      }
+    }
+  }
+
+  void rehash(size_t table_size)
+  {
+    _table.assign(table_size, NONE);
+    for (uint32_t id = 0; id < _strings.size(); id++)
+    {
+      if (_counts[id].load(std::memory_order_relaxed) > 0)
+      {
+        insertSlot(id);
+      }
+    }
+  }
+};
+
+}  // namespace PJ
+
+#endif  // PJ_STRING_DICTIONARY_H
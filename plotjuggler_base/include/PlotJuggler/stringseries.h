@@ -9,11 +9,17 @@
 
 #include "PlotJuggler/timeseries.h"
 #include "PlotJuggler/string_ref_sso.h"
-#include <algorithm>
-#include <unordered_set>
+#include "PlotJuggler/string_dictionary.h"
+#include <stdexcept>
+#include <vector>
 
 namespace PJ
 {
+/**
+ * @brief Series of strings. Long strings are stored only once, in the global
+ * StringDictionary shared by all the series. Each sample holds a reference to
+ * its string, released when the sample is removed (popFront(), clear(), etc.).
+ */
 class StringSeries : public TimeseriesBase<StringRef>
 {
 public:
@@ -25,17 +31,84 @@ public:
   }
 
   StringSeries(const StringSeries& other) = delete;
-  StringSeries(StringSeries&& other) = default;
+
+  StringSeries(StringSeries&& other) : TimeseriesBase<StringRef>(std::move(other))
+  {
+    // the references to the strings belong to this series now
+    other._points = Storage();
+  }
 
   StringSeries& operator=(const StringSeries& other) = delete;
-  StringSeries& operator=(StringSeries&& other) = default;
+
+  StringSeries& operator=(StringSeries&& other)
+  {
+    if (this != &other)
+    {
+      releaseStrings(size());
+      TimeseriesBase<StringRef>::operator=(std::move(other));
+      other._points = Storage();
+    }
+    return *this;
+  }
+
+  ~StringSeries() override
+  {
+    releaseStrings(size());
+  }
+
+  void clonePoints(const PlotDataBase<double, StringRef>& other) override
+  {
+    if (&other == this)
+    {
+      return;
+    }
+    releaseStrings(size());
+    TimeseriesBase<StringRef>::clonePoints(other);
+    internStrings();
+  }
+
+  /// See PlotDataBase::swapPoints(). Other must be a StringSeries, whose
+  /// points hold a reference to their strings too.
+  void swapPoints(PlotDataBase<double, StringRef>& other) override
+  {
+    if (!dynamic_cast<StringSeries*>(&other))
+    {
+      throw std::runtime_error("StringSeries::swapPoints : other is not a StringSeries");
+    }
+    TimeseriesBase<StringRef>::swapPoints(other);
+  }
+
+  void splice(PlotDataBase<double, StringRef>& other) override
+  {
+    if (dynamic_cast<StringSeries*>(&other))
+    {
+      TimeseriesBase<StringRef>::splice(other);
+      return;
+    }
+    // the strings of other are not in the dictionary
+    for (size_t i = 0; i < other.size(); i++)
+    {
+      pushBack(other.at(i));
+    }
+    other.clear();
+  }
 
   virtual void clear() override
   {
-    _storage.clear();
+    releaseStrings(size());
     TimeseriesBase<StringRef>::clear();
   }
 
+  void popFront() override
+  {
+    const StringRef& str = _points.y(0);
+    if (!str.isSSO())
+    {
+      StringDictionary::global().release({ str.data(), str.size() });
+    }
+    TimeseriesBase<StringRef>::popFront();
+  }
+
   void pushBack(const Point& p) override
   {
     auto temp = p;
@@ -57,22 +130,63 @@ public:
     }
     else
     {
-      // save a copy of the string in the flywheel structure _storage
-      // create a reference to that cached value.
-      _tmp_str.assign(str.data(), str.size());
+      // the string is stored (only once) in the global dictionary.
+      // Create a reference to that value.
+      const auto entry = StringDictionary::global().intern({ str.data(), str.size() });
+      TimeseriesBase<StringRef>::pushBack(
+          { p.x, StringRef(entry.str.data(), entry.str.size()) });
+    }
+  }
+
+  void insert(Iterator it, Point&& p) override
+  {
+    const auto& str = p.y;
+    if (str.data() == nullptr || str.size() == 0)
+    {
+      return;
+    }
+    if (!str.isSSO())
+    {
+      const auto entry = StringDictionary::global().intern({ str.data(), str.size() });
+      p.y = StringRef(entry.str.data(), entry.str.size());
+    }
+    TimeseriesBase<StringRef>::insert(it, std::move(p));
+  }
 
-      auto it = _storage.find(_tmp_str);
-      if (it == _storage.end())
+private:
+  // release the strings of the first count points
+  void releaseStrings(size_t count)
+  {
+    std::vector<std::string_view> strings;
+    for (size_t i = 0; i < count; i++)
+    {
+      const StringRef& str = _points.y(i);
+      if (!str.isSSO())
       {
-        it = _storage.insert(_tmp_str).first;
+        strings.emplace_back(str.data(), str.size());
       }
-      TimeseriesBase<StringRef>::pushBack({ p.x, StringRef(*it) });
+    }
+    if (!strings.empty())
+    {
+      StringDictionary::global().release(strings.data(), strings.size());
     }
   }
 
-private:
-  std::string _tmp_str;
-  std::unordered_set<std::string> _storage;
+  // intern the long strings of the points, that are not referenced yet
+  void internStrings()
+  {
+    auto& dictionary = StringDictionary::global();
+    for (size_t i = 0; i < size(); i++)
+    {
+      const auto point = this->at(i);
+      const StringRef& str = point.y;
+      if (!str.isSSO() && str.size() > 0)
+      {
+        const auto entry = dictionary.intern({ str.data(), str.size() });
+        point = Point(point.x, StringRef(entry.str.data(), entry.str.size()));
+      }
+    }
+  }
 };
 
 }  // namespace PJ
@@ -17,6 +17,11 @@ class TimeseriesBase : public PlotDataBase<double, Value>
 {
 protected:
   double _max_range_x;
+  bool _ring_buffer = false;
+  size_t _ring_capacity = 0;
+  double _ring_range_x = 0;  // maximum range used to estimate _ring_capacity
+  // result of the last getIndexFromX(), where the next search starts from
+  mutable size_t _cursor = 0;
   using PlotDataBase<double, Value>::_points;
 
 public:
@@ -41,7 +46,14 @@ public:
 
   void setMaximumRangeX(double max_range)
   {
-    _max_range_x = max_range;
+    if (max_range != _max_range_x)
+    {
+      _max_range_x = max_range;
+      if (max_range != _ring_range_x)
+      {
+        _ring_capacity = 0;  // estimate again
+      }
+    }
     trimRange();
   }
 
@@ -50,12 +62,49 @@ public:
     return _max_range_x;
   }
 
+  /**
+   * @brief When enabled, the memory needed to store maximumRangeX() seconds of
+   * data is preallocated, estimating the rate of the samples received so far.
+   * Once the buffer is full, old samples are evicted in O(1) and new ones are
+   * stored without allocating memory. Used in streaming.
+   */
+  void setRingBufferMode(bool enable)
+  {
+    if (enable == _ring_buffer)
+    {
+      return;
+    }
+    _ring_buffer = enable;
+    _ring_capacity = 0;
+    if (!enable)
+    {
+      _points.reserve(0);
+    }
+    trimRange();
+  }
+
+  bool isRingBuffer() const
+  {
+    return _ring_buffer;
+  }
+
+  /// The timestamps are sorted: the range is given by the first and last
+  /// sample, in O(1), even when samples are removed with popFront().
+  RangeOpt rangeX() const override
+  {
+    if (_points.empty())
+    {
+      return std::nullopt;
+    }
+    return Range{ this->front().x, this->back().x };
+  }
+
   int getIndexFromX(double x) const;
 
   std::optional<Value> getYfromX(double x) const
   {
     int index = getIndexFromX(x);
-    return (index < 0) ? std::nullopt : std::optional(_points[index].y);
+    return (index < 0) ? std::nullopt : std::optional(_points.y(index));
   }
 
   void pushBack(const Point& p) override
@@ -66,38 +115,84 @@ public:
 
   void pushBack(Point&& p) override
   {
-    bool need_sorting = (!_points.empty() && p.x < this->back().x);
-
-    if (need_sorting)
+    if (!this->acceptPoint(p))
     {
-      auto it = std::upper_bound(_points.begin(), _points.end(), p,
-                                 [](const auto& a, const auto& b) { return a.x < b.x; });
-      PlotDataBase<double, Value>::insert(it, std::move(p));
+      return;
     }
-    else
+    this->_epoch++;
+    // samples older than back() are staged and sorted later, all together.
+    // They don't change back().x, therefore there is nothing to trim.
+    if (_points.push_back_sorted(p.x, std::move(p.y)))
     {
-      PlotDataBase<double, Value>::pushBack(std::move(p));
+      trimRange();
     }
+  }
+
+  /// If the points of other are older than back(), they are merged one by one.
+  void splice(PlotDataBase<double, Value>& other) override
+  {
+    if (!_points.empty() && other.size() > 0 && other.front().x < this->back().x)
+    {
+      for (size_t i = 0; i < other.size(); i++)
+      {
+        pushBack(other.at(i));
+      }
+      other.clear();
+      return;
+    }
+    PlotDataBase<double, Value>::splice(other);
     trimRange();
   }
 
-private:
+protected:
+  void appendBlock(const double* x, const Value* y, size_t count) override
+  {
+    this->updateRanges(x, y, count);
+    // even if some samples of the block were staged (older than back()),
+    // the others might have moved back().x forward.
+    _points.append_sorted(x, y, count);
+    trimRange();
+  }
+
+  /// Remove the points older than back().x - maximumRangeX().
   void trimRange()
   {
     if (_max_range_x < std::numeric_limits<double>::max() && !_points.empty())
     {
-      auto const back_point_x = _points.back().x;
-      while (_points.size() > 2 && (back_point_x - _points.front().x) > _max_range_x)
+      auto const back_point_x = this->back().x;
+      while (_points.size() > 2 && (back_point_x - _points.x(0)) > _max_range_x)
       {
         this->popFront();
       }
+      if (_ring_buffer && _ring_capacity == 0)
+      {
+        reserveRingBuffer();
+      }
     }
   }
 
-  static bool TimeCompare(const Point& a, const Point& b)
+private:
+  void reserveRingBuffer()
   {
-    return a.x < b.x;
+    const double span = this->back().x - _points.x(0);
+    // wait until the rate of the samples can be estimated reliably
+    if (_points.size() < MIN_SAMPLES_RATE || !(span > 0 && span >= 0.1 * _max_range_x))
+    {
+      return;
+    }
+    const double rate = double(_points.size() - 1) / span;
+    // 25% of margin, to tolerate some jitter of the rate
+    const double capacity = 1.25 * rate * _max_range_x;
+    _ring_capacity = size_t(std::min(capacity, double(MAX_RING_CAPACITY)));
+    _ring_range_x = _max_range_x;
+    _points.reserve(_ring_capacity);
   }
+
+  enum
+  {
+    MIN_SAMPLES_RATE = 16,
+    MAX_RING_CAPACITY = 64 * 1024 * 1024
+  };
 };
 
 //--------------------
@@ -109,20 +204,17 @@ inline int TimeseriesBase<Value>::getIndexFromX(double x) const
   {
     return -1;
   }
-  auto lower =
-      std::lower_bound(_points.begin(), _points.end(), Point(x, {}), TimeCompare);
-  auto index = std::distance(_points.begin(), lower);
+  // tracker and playback move in small steps: start from the previous result
+  size_t index = _points.lowerBound(x, _cursor);
+  _cursor = index;
 
   if (index >= _points.size())
   {
     return _points.size() - 1;
   }
-  if (index < 0)
-  {
-    return 0;
-  }
 
-  if (index > 0 && (abs(_points[index - 1].x - x) < abs(_points[index].x - x)))
+  if (index > 0 &&
+      (std::abs(_points.x(index - 1) - x) < std::abs(_points.x(index) - x)))
   {
     index = index - 1;
   }
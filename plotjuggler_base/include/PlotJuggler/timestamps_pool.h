@@ -0,0 +1,106 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PJ_TIMESTAMPS_POOL_H
+#define PJ_TIMESTAMPS_POOL_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+
+namespace PJ
+{
+/**
+ * @brief Compressed timestamps, shared by the chunks of different series.
+ *
+ * All the fields of a message (ROS, ULog, Parquet, etc.) become separate
+ * series with identical timestamps. Instead of storing a copy of them for each
+ * series, the compressed chunks get a reference to the same stream.
+ *
+ * The pool doesn't own the streams: they are released when the last chunk
+ * that uses them is released. It is thread-safe.
+ */
+class TimestampsPool
+{
+public:
+  using Stream = std::shared_ptr<const std::vector<uint64_t>>;
+
+  /// Pool used by all the instances of PlotData.
+  static TimestampsPool& global();
+
+  /// Return the stream equal to "stream" if already in the pool, or add it.
+  Stream intern(std::vector<uint64_t>&& stream)
+  {
+    const uint64_t hash = Hash(stream);
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& bucket = _table[hash];
+    for (const auto& weak : bucket)
+    {
+      auto existing = weak.lock();
+      if (existing && *existing == stream)
+      {
+        return existing;
+      }
+    }
+    auto added = std::make_shared<const std::vector<uint64_t>>(std::move(stream));
+    bucket.push_back(added);
+    if (++_entries > _purge_threshold)
+    {
+      purge();
+    }
+    return added;
+  }
+
+  /// Number of streams in the pool, including the ones not purged yet.
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries;
+  }
+
+private:
+  mutable std::mutex _mutex;
+  std::unordered_map<uint64_t, std::vector<std::weak_ptr<const std::vector<uint64_t>>>>
+      _table;
+  size_t _entries = 0;
+  size_t _purge_threshold = 1024;
+
+  static uint64_t Hash(const std::vector<uint64_t>& stream)
+  {
+    uint64_t hash = stream.size();
+    for (uint64_t word : stream)
+    {
+      hash = (hash ^ word) * 0x100000001b3ull;
+      hash ^= hash >> 29;
+    }
+    return hash;
+  }
+
+  // remove the entries of the streams already released. The threshold grows
+  // with the number of entries, to keep the amortized cost constant.
+  void purge()
+  {
+    _entries = 0;
+    for (auto it = _table.begin(); it != _table.end();)
+    {
+      auto& bucket = it->second;
+      bucket.erase(std::remove_if(bucket.begin(), bucket.end(),
+                                  [](const auto& weak) { return weak.expired(); }),
+                   bucket.end());
+      _entries += bucket.size();
+      it = bucket.empty() ? _table.erase(it) : std::next(it);
+    }
+    _purge_threshold = std::max<size_t>(1024, 2 * _entries);
+  }
+};
+
+}  // namespace PJ
+
+#endif  // PJ_TIMESTAMPS_POOL_H
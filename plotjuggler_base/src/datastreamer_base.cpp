@@ -24,6 +24,10 @@ void PJ::DataStreamer::setMaximumRangeX(double range)
   {
     it.second.setMaximumRangeX(range);
   }
+  for (auto& it : dataMap().blobs)
+  {
+    it.second.setMaximumRangeX(range);
+  }
 }
 
 void DataStreamer::setParserFactories(ParserFactories* parsers)
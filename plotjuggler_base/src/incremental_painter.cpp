@@ -0,0 +1,224 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QPainter>
+#include "qwt_plot.h"
+#include "qwt_plot_curve.h"
+
+#include "incremental_painter.h"
+#include "plotcurve.h"
+#include "timeseries_qwt.h"
+
+static bool SameMap(const QwtScaleMap& a, const QwtScaleMap& b)
+{
+  return a.s1() == b.s1() && a.s2() == b.s2() && a.p1() == b.p1() && a.p2() == b.p2();
+}
+
+bool IncrementalPainter::getCurves(const QwtPlot& plot, std::vector<CurveState>& curves)
+{
+  curves.clear();
+  for (const auto item : plot.itemList(QwtPlotItem::Rtti_PlotCurve))
+  {
+    if (!item->isVisible())
+    {
+      continue;
+    }
+    auto curve = dynamic_cast<const PlotCurve*>(item);
+    if (!curve || !curve->canPrepareLines() || curve->xAxis() != QwtPlot::xBottom ||
+        curve->yAxis() != QwtPlot::yLeft)
+    {
+      return false;
+    }
+    CurveState state;
+    state.curve = curve;
+    state.data = curve->data();
+    state.pen = curve->pen();
+    const size_t size = curve->dataSize();
+    state.last_x = (size == 0) ? std::numeric_limits<double>::lowest() :
+                                 curve->data()->sample(size - 1).x();
+    if (auto wrapper = dynamic_cast<const QwtSeriesWrapper*>(curve->data()))
+    {
+      state.series = wrapper->plotData();
+      state.epoch = state.series->modificationEpoch();
+      if (state.series->size() > 0)
+      {
+        state.back = state.series->back();
+      }
+    }
+    curves.push_back(state);
+  }
+  return true;
+}
+
+bool IncrementalPainter::onlyAppended(const CurveState& curr, const CurveState& prev)
+{
+  if (!curr.series || curr.epoch == prev.epoch ||
+      prev.last_x == std::numeric_limits<double>::lowest())
+  {
+    return true;
+  }
+  // the samples painted previously are still there if the last one is
+  const auto& columns = curr.series->columns();
+  const size_t index = columns.lowerBound(prev.back.x);
+  return index < columns.size() && columns.x(index) == prev.back.x &&
+         columns.y(index) == prev.back.y;
+}
+
+bool IncrementalPainter::isScrollable(const QwtPlot& plot,
+                                      const std::vector<CurveState>& curves) const
+{
+  const QwtScaleMap x_map = plot.canvasMap(QwtPlot::xBottom);
+  const double span = x_map.s2() - x_map.s1();
+  const double prev_span = _x_map.s2() - _x_map.s1();
+
+  if (!_valid || _canvas_rect != QRectF(plot.canvas()->contentsRect()) ||
+      _layer.devicePixelRatioF() != plot.canvas()->devicePixelRatioF() ||
+      !SameMap(_y_map, plot.canvasMap(QwtPlot::yLeft)) || x_map.p1() != _x_map.p1() ||
+      x_map.p2() != _x_map.p2() || std::abs(span - prev_span) > 1e-9 * std::abs(span))
+  {
+    return false;
+  }
+  // the X axis can only move forward, by less than the width of the canvas
+  const double shift = _x_map.transform(x_map.s1()) - _x_map.p1();
+  if (shift < 0 || shift >= std::abs(x_map.pDist()))
+  {
+    return false;
+  }
+
+  if (curves.size() != _curves.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < curves.size(); i++)
+  {
+    const auto& curr = curves[i];
+    const auto& prev = _curves[i];
+    if (curr.curve != prev.curve || curr.data != prev.data || curr.pen != prev.pen ||
+        curr.last_x < prev.last_x || !onlyAppended(curr, prev))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IncrementalPainter::canScroll(const QwtPlot& plot) const
+{
+  std::vector<CurveState> curves;
+  return _allowed && getCurves(plot, curves) && isScrollable(plot, curves);
+}
+
+void IncrementalPainter::drawCurves(const std::vector<CurveState>& curves,
+                                    const QwtScaleMap& x_map, const QRectF& rect)
+{
+  QPainter painter(&_layer);
+  painter.setClipRect(rect);
+  painter.setCompositionMode(QPainter::CompositionMode_Clear);
+  painter.fillRect(rect, Qt::transparent);
+  painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+  for (const auto& state : curves)
+  {
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing,
+                          state.curve->testRenderHint(QwtPlotItem::RenderAntialiased));
+    state.curve->draw(&painter, x_map, _y_map, rect);
+    painter.restore();
+  }
+}
+
+bool IncrementalPainter::paint(const QwtPlot& plot, QPainter* painter)
+{
+  std::vector<CurveState> curves;
+  if (!_allowed || !getCurves(plot, curves))
+  {
+    _allowed = false;
+    _valid = false;
+    return false;
+  }
+  _allowed = false;
+
+  const QRectF canvas_rect = plot.canvas()->contentsRect();
+  const qreal ratio = plot.canvas()->devicePixelRatioF();
+
+  if (isScrollable(plot, curves))
+  {
+    // the shift is rounded to entire pixels: the layer might be misaligned
+    // by less than half a pixel, but _x_map keeps track of it.
+    const QwtScaleMap x_map = plot.canvasMap(QwtPlot::xBottom);
+    const double shift = _x_map.transform(x_map.s1()) - _x_map.p1();
+    const int shift_pixels = int(std::lround(shift * ratio));
+    _layer.scroll(-shift_pixels, 0, _layer.rect());
+
+    const double span = _x_map.s2() - _x_map.s1();
+    const double s1 = _x_map.invTransform(_x_map.p1() + shift_pixels / ratio);
+    _x_map.setScaleInterval(s1, s1 + span);
+
+    // redraw from the oldest "last sample" of the previous frame (the segments
+    // that start there are new), including the region exposed by the scroll.
+    double first_x = std::numeric_limits<double>::max();
+    double pen_width = 1.0;
+    for (const auto& state : _curves)
+    {
+      first_x = std::min(first_x, state.last_x);
+      pen_width = std::max(pen_width, state.pen.widthF());
+    }
+    double left = _x_map.transform(first_x) - pen_width - 1.0;
+    left = std::min(left, canvas_rect.right() - shift_pixels / ratio);
+    left = std::clamp(std::floor(left), canvas_rect.left(), canvas_rect.right());
+
+    const QRectF strip(QPointF(left, canvas_rect.top()), canvas_rect.bottomRight());
+    QwtScaleMap strip_map = _x_map;
+    strip_map.setPaintInterval(left, _x_map.p2());
+    strip_map.setScaleInterval(_x_map.invTransform(left), _x_map.s2());
+    drawCurves(curves, strip_map, strip);
+  }
+  else
+  {
+    const QSize size = plot.canvas()->size();
+    if (_layer.size() != size * ratio || _layer.devicePixelRatioF() != ratio)
+    {
+      _layer = QPixmap(size * ratio);
+      _layer.setDevicePixelRatio(ratio);
+    }
+    _layer.fill(Qt::transparent);
+    _x_map = plot.canvasMap(QwtPlot::xBottom);
+    _y_map = plot.canvasMap(QwtPlot::yLeft);
+    drawCurves(curves, _x_map, canvas_rect);
+  }
+  _canvas_rect = canvas_rect;
+  _curves = std::move(curves);
+  _valid = true;
+
+  // same as QwtPlot::drawItems(), but the curves are taken from the layer
+  bool layer_drawn = false;
+  for (const auto item : plot.itemList())
+  {
+    if (!item->isVisible())
+    {
+      continue;
+    }
+    if (item->rtti() == QwtPlotItem::Rtti_PlotCurve)
+    {
+      if (!layer_drawn)
+      {
+        painter->drawPixmap(QPointF(0, 0), _layer);
+        layer_drawn = true;
+      }
+      continue;
+    }
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing,
+                           item->testRenderHint(QwtPlotItem::RenderAntialiased));
+    item->draw(painter, plot.canvasMap(item->xAxis()), plot.canvasMap(item->yAxis()),
+               canvas_rect);
+    painter->restore();
+  }
+  return true;
+}
@@ -0,0 +1,88 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef INCREMENTAL_PAINTER_H
+#define INCREMENTAL_PAINTER_H
+
+#include <vector>
+#include <QPen>
+#include <QPixmap>
+#include "qwt_scale_map.h"
+#include "PlotJuggler/plotdata.h"
+
+class QwtPlot;
+class PlotCurve;
+
+/**
+ * @brief Paints the curves of a QwtPlot in a layer that is reused by the
+ * following frame, when the series received only new samples (streaming).
+ *
+ * The layer is scrolled by the shift of the X axis and only the region that
+ * contains the samples appended since the previous frame is drawn again.
+ * The whole layer is redrawn if the Y axis, the width of the X range, the size
+ * of the canvas or the curves (pen, visibility, series) changed.
+ *
+ * The whole layer is redrawn also if the last sample painted in the previous
+ * frame was modified or removed (data cleared or recalculated by a transform).
+ * Samples inserted before it are not painted until the layer is redrawn entirely.
+ */
+class IncrementalPainter
+{
+public:
+  /// Allow (or not) the next call of paint(). Otherwise, paint() returns false.
+  void allowNextFrame(bool allow = true)
+  {
+    _allowed = allow;
+  }
+
+  bool isAllowed() const
+  {
+    return _allowed;
+  }
+
+  /// True if the next call of paint() is expected to scroll the layer.
+  bool canScroll(const QwtPlot& plot) const;
+
+  /**
+   * @brief Paint all the items of the plot on the canvas, as QwtPlot::drawCanvas.
+   *
+   * @return false if the plot must be painted as usual, because the next frame
+   * was not allowed or the curves don't support it (XY curves, other styles).
+   */
+  bool paint(const QwtPlot& plot, QPainter* painter);
+
+private:
+  struct CurveState
+  {
+    const PlotCurve* curve = nullptr;
+    const void* data = nullptr;
+    QPen pen;
+    double last_x = 0;  // time of the last sample painted
+    // series painted, to detect the samples modified since the previous frame
+    const PJ::PlotDataXY* series = nullptr;
+    uint64_t epoch = 0;
+    PJ::PlotDataXY::Point back = { 0, 0 };  // last sample of series, if not empty
+  };
+
+  bool _allowed = false;
+  bool _valid = false;
+  QPixmap _layer;
+  QwtScaleMap _x_map;  // the content of the layer is aligned to this map
+  QwtScaleMap _y_map;
+  QRectF _canvas_rect;
+  std::vector<CurveState> _curves;
+
+  static bool getCurves(const QwtPlot& plot, std::vector<CurveState>& curves);
+
+  bool isScrollable(const QwtPlot& plot, const std::vector<CurveState>& curves) const;
+
+  static bool onlyAppended(const CurveState& curr, const CurveState& prev);
+
+  void drawCurves(const std::vector<CurveState>& curves, const QwtScaleMap& x_map,
+                  const QRectF& rect);
+};
+
+#endif  // INCREMENTAL_PAINTER_H
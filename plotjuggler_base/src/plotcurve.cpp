@@ -0,0 +1,106 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include "qwt_clipper.h"
+#include "qwt_painter.h"
+#include "qwt_scale_map.h"
+
+#include "plotcurve.h"
+#include "timeseries_qwt.h"
+
+static bool SameMap(const QwtScaleMap& a, const QwtScaleMap& b)
+{
+  return a.s1() == b.s1() && a.s2() == b.s2() && a.p1() == b.p1() && a.p2() == b.p2();
+}
+
+bool PlotCurve::canPrepareLines() const
+{
+  return style() == QwtPlotCurve::Lines && dynamic_cast<QwtTimeseries*>(data());
+}
+
+void PlotCurve::prepareLines(const QwtScaleMap& xMap, const QwtScaleMap& yMap,
+                             const QRectF& canvasRect, double pen_width)
+{
+  _prepared.valid = buildPolyline(xMap, yMap, canvasRect, pen_width, _prepared.polyline);
+  _prepared.x_map = xMap;
+  _prepared.y_map = yMap;
+  _prepared.canvas_rect = canvasRect;
+  _prepared.data_size = dataSize();
+}
+
+void PlotCurve::resetPreparedLines()
+{
+  _prepared.valid = false;
+  _prepared.polyline.clear();
+}
+
+bool PlotCurve::buildPolyline(const QwtScaleMap& xMap, const QwtScaleMap& yMap,
+                              const QRectF& canvasRect, double pen_width,
+                              QPolygonF& polyline) const
+{
+  auto series = dynamic_cast<QwtTimeseries*>(data());
+
+  const double left = std::min(xMap.s1(), xMap.s2());
+  const double right = std::max(xMap.s1(), xMap.s2());
+  const auto columns = static_cast<size_t>(
+      std::max(1.0, std::ceil(std::abs(xMap.pDist()) * _level_of_detail)));
+
+  if (!series || !series->decimate({ left, right }, columns, _decimated))
+  {
+    return false;
+  }
+
+  polyline.resize(int(_decimated.size()));
+  for (size_t i = 0; i < _decimated.size(); i++)
+  {
+    polyline[int(i)] = QPointF(xMap.transform(_decimated[i].x()),
+                               yMap.transform(_decimated[i].y()));
+  }
+
+  if (testPaintAttribute(ClipPolygons))
+  {
+    const QRectF clip_rect = canvasRect.adjusted(-pen_width, -pen_width, pen_width,
+                                                 pen_width);
+    QwtClipper::clipPolygonF(clip_rect, polyline, false);
+  }
+  return true;
+}
+
+void PlotCurve::drawLines(QPainter* painter, const QwtScaleMap& xMap,
+                          const QwtScaleMap& yMap, const QRectF& canvasRect, int from,
+                          int to) const
+{
+  const bool whole_series = (from == 0 && to + 1 == int(dataSize()));
+  if (!whole_series)
+  {
+    QwtPlotCurve::drawLines(painter, xMap, yMap, canvasRect, from, to);
+    return;
+  }
+
+  // the prepared polyline is used once, if it was computed for the same view
+  const bool use_prepared = _prepared.valid && SameMap(_prepared.x_map, xMap) &&
+                            SameMap(_prepared.y_map, yMap) &&
+                            _prepared.canvas_rect == canvasRect &&
+                            _prepared.data_size == dataSize();
+  _prepared.valid = false;
+
+  QPolygonF polyline;
+  if (use_prepared)
+  {
+    polyline.swap(_prepared.polyline);
+  }
+  else
+  {
+    const qreal pen_width = QwtPainter::effectivePenWidth(painter->pen());
+    if (!buildPolyline(xMap, yMap, canvasRect, pen_width, polyline))
+    {
+      QwtPlotCurve::drawLines(painter, xMap, yMap, canvasRect, from, to);
+      return;
+    }
+  }
+  QwtPainter::drawPolyline(painter, polyline);
+}
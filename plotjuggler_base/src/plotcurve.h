@@ -0,0 +1,81 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef PLOTCURVE_H
+#define PLOTCURVE_H
+
+#include <vector>
+#include <QPolygonF>
+#include "qwt_plot_curve.h"
+#include "qwt_scale_map.h"
+
+/**
+ * @brief QwtPlotCurve that draws the lines of a QwtTimeseries using at most
+ * a few points for each pixel column (see QwtTimeseries::decimate), instead
+ * of iterating over all the samples of the series.
+ *
+ * The polyline can be computed in advance by prepareLines(), even in a
+ * worker thread: the next drawLines() only has to paint it.
+ */
+class PlotCurve : public QwtPlotCurve
+{
+public:
+  explicit PlotCurve(const QString& title) : QwtPlotCurve(title)
+  {
+  }
+
+  /// True if drawLines() would use the decimated polyline.
+  bool canPrepareLines() const;
+
+  /**
+   * @brief Compute the polyline that drawLines() will paint with these maps.
+   *
+   * It can be called from any thread, as long as no other thread is accessing
+   * the series of this curve (reading the series updates its caches).
+   */
+  void prepareLines(const QwtScaleMap& xMap, const QwtScaleMap& yMap,
+                    const QRectF& canvasRect, double pen_width);
+
+  /// Discard the polyline computed by prepareLines().
+  void resetPreparedLines();
+
+  /// Fraction of the pixel columns used by the decimation, in (0, 1].
+  /// Lower values are faster to prepare and paint, but less accurate.
+  void setLevelOfDetail(double lod)
+  {
+    _level_of_detail = lod;
+  }
+
+  double levelOfDetail() const
+  {
+    return _level_of_detail;
+  }
+
+protected:
+  void drawLines(QPainter* painter, const QwtScaleMap& xMap, const QwtScaleMap& yMap,
+                 const QRectF& canvasRect, int from, int to) const override;
+
+private:
+  struct PreparedLines
+  {
+    bool valid = false;
+    QwtScaleMap x_map;
+    QwtScaleMap y_map;
+    QRectF canvas_rect;
+    size_t data_size = 0;
+    QPolygonF polyline;
+  };
+
+  mutable PreparedLines _prepared;
+  mutable std::vector<QPointF> _decimated;
+  double _level_of_detail = 1.0;
+
+  bool buildPolyline(const QwtScaleMap& xMap, const QwtScaleMap& yMap,
+                     const QRectF& canvasRect, double pen_width,
+                     QPolygonF& polyline) const;
+};
+
+#endif  // PLOTCURVE_H
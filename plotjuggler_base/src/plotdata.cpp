@@ -5,9 +5,25 @@
  */
 
 #include "PlotJuggler/plotdata.h"
+#include <functional>
+#include <queue>
 
 namespace PJ
 {
+TimestampsPool& TimestampsPool::global()
+{
+  static TimestampsPool pool;
+  return pool;
+}
+
+StringDictionary& StringDictionary::global()
+{
+  // never destroyed: series in static objects might release their strings
+  // after the end of main()
+  static auto dictionary = new StringDictionary();
+  return *dictionary;
+}
+
 template <typename T>
 typename std::unordered_map<std::string, T>::iterator
 addImpl(std::unordered_map<std::string, T>& series, const std::string& name,
@@ -66,6 +82,12 @@ StringSeriesMap::iterator PlotDataMapRef::addStringSeries(const std::string& nam
   return addImpl(strings, name, group);
 }
 
+BlobSeriesMap::iterator PlotDataMapRef::addBlobSeries(const std::string& name,
+                                                      PlotGroup::Ptr group)
+{
+  return addImpl(blobs, name, group);
+}
+
 PlotDataXY& PlotDataMapRef::getOrCreateScatterXY(const std::string& name,
                                                  PlotGroup::Ptr group)
 {
@@ -90,6 +112,12 @@ PlotDataAny& PlotDataMapRef::getOrCreateUserDefined(const std::string& name,
   return getOrCreateImpl(user_defined, name, group);
 }
 
+BlobSeries& PlotDataMapRef::getOrCreateBlobSeries(const std::string& name,
+                                                  PlotGroup::Ptr group)
+{
+  return getOrCreateImpl(blobs, name, group);
+}
+
 PlotGroup::Ptr PlotDataMapRef::getOrCreateGroup(const std::string& name)
 {
   if (name.empty())
@@ -104,6 +132,18 @@ PlotGroup::Ptr PlotDataMapRef::getOrCreateGroup(const std::string& name)
   return group;
 }
 
+NumericHandle PlotDataMapRef::getNumericHandle(const std::string& name,
+                                               PlotGroup::Ptr group)
+{
+  return { &getOrCreateImpl(numeric, name, group), _epoch };
+}
+
+StringSeriesHandle PlotDataMapRef::getStringSeriesHandle(const std::string& name,
+                                                         PlotGroup::Ptr group)
+{
+  return { &getOrCreateImpl(strings, name, group), _epoch };
+}
+
 std::unordered_set<std::string> PlotDataMapRef::getAllNames() const
 {
   std::unordered_set<std::string> out;
@@ -119,14 +159,20 @@ std::unordered_set<std::string> PlotDataMapRef::getAllNames() const
   {
     out.insert(it.first);
   }
+  for (auto& it : blobs)
+  {
+    out.insert(it.first);
+  }
   return out;
 }
 
 void PlotDataMapRef::clear()
 {
+  _epoch++;
   numeric.clear();
   strings.clear();
   user_defined.clear();
+  blobs.clear();
 }
 
 void PlotDataMapRef::setMaximumRangeX(double range)
@@ -143,11 +189,143 @@ void PlotDataMapRef::setMaximumRangeX(double range)
   {
     it.second.setMaximumRangeX(range);
   }
+  for (auto& it : blobs)
+  {
+    it.second.setMaximumRangeX(range);
+  }
+}
+
+void PlotDataMapRef::setRingBufferMode(bool enable)
+{
+  for (auto& it : numeric)
+  {
+    it.second.setRingBufferMode(enable);
+  }
+  for (auto& it : strings)
+  {
+    it.second.setRingBufferMode(enable);
+  }
+  for (auto& it : user_defined)
+  {
+    it.second.setRingBufferMode(enable);
+  }
+  for (auto& it : blobs)
+  {
+    it.second.setRingBufferMode(enable);
+  }
+}
+
+void PlotDataMapRef::compressColdChunks()
+{
+  for (auto& it : numeric)
+  {
+    it.second.compressColdChunks();
+  }
+  for (auto& it : scatter_xy)
+  {
+    it.second.compressColdChunks();
+  }
+}
+
+template <class SeriesMap, class Function>
+static void ForEachSeries(SeriesMap& series_map, Function&& func)
+{
+  for (auto& it : series_map)
+  {
+    func(it.second);
+  }
+}
+
+size_t PlotDataMapRef::memoryUsage() const
+{
+  size_t total = 0;
+  auto add = [&](const auto& series) { total += series.memoryUsage(); };
+  ForEachSeries(numeric, add);
+  ForEachSeries(scatter_xy, add);
+  ForEachSeries(strings, add);
+  ForEachSeries(user_defined, add);
+  ForEachSeries(blobs, add);
+  return total;
+}
+
+std::map<std::string, size_t> PlotDataMapRef::memoryUsagePerGroup() const
+{
+  std::map<std::string, size_t> usage;
+  auto add = [&](const auto& series) {
+    const auto& group = series.group();
+    usage[group ? group->name() : std::string()] += series.memoryUsage();
+  };
+  ForEachSeries(numeric, add);
+  ForEachSeries(scatter_xy, add);
+  ForEachSeries(strings, add);
+  ForEachSeries(user_defined, add);
+  ForEachSeries(blobs, add);
+  return usage;
+}
+
+size_t PlotDataMapRef::enforceMemoryBudget(size_t max_bytes)
+{
+  const size_t initial_usage = memoryUsage();
+  size_t usage = initial_usage;
+  if (usage <= max_bytes)
+  {
+    return 0;
+  }
+
+  // Timeseries sorted by their oldest sample. Scatter XY series are excluded:
+  // their samples are not sorted by time.
+  struct Candidate
+  {
+    double front_x;
+    // remove the first chunk, return the memory released and update front_x
+    std::function<size_t(double&)> evict;
+
+    bool operator<(const Candidate& other) const
+    {
+      return front_x > other.front_x;
+    }
+  };
+  std::priority_queue<Candidate> queue;
+
+  auto add = [&](auto& series) {
+    if (series.columns().chunksCount() < 2)
+    {
+      return;
+    }
+    auto* ptr = &series;
+    queue.push({ series.front().x, [ptr](double& front_x) -> size_t {
+                  // the memory of the removed chunk is kept for reuse by the
+                  // ring buffer (or as spare chunk): give it back as well.
+                  const size_t released = ptr->popFrontChunk() + ptr->shrinkToFit();
+                  front_x = ptr->size() > 0 ? ptr->front().x : 0;
+                  return released;
+                } });
+  };
+  ForEachSeries(numeric, add);
+  ForEachSeries(strings, add);
+  ForEachSeries(user_defined, add);
+  ForEachSeries(blobs, add);
+
+  while (usage > max_bytes && !queue.empty())
+  {
+    Candidate candidate = queue.top();
+    queue.pop();
+    const size_t released = candidate.evict(candidate.front_x);
+    usage -= std::min(usage, released);
+    // when nothing is released (last chunk), removing more samples of this
+    // series would not help.
+    if (released > 0)
+    {
+      queue.push(std::move(candidate));
+    }
+  }
+  return initial_usage - usage;
 }
 
 bool PlotDataMapRef::erase(const std::string& name)
 {
   bool erased = false;
+  _epoch++;
   auto num_it = numeric.find(name);
   if (num_it != numeric.end())
   {
@@ -168,6 +346,13 @@ bool PlotDataMapRef::erase(const std::string& name)
     user_defined.erase(any_it);
     erased = true;
   }
+
+  auto blob_it = blobs.find(name);
+  if (blob_it != blobs.end())
+  {
+    blobs.erase(blob_it);
+    erased = true;
+  }
   return erased;
 }
 
@@ -7,6 +7,8 @@
 #include "PlotJuggler/plotwidget_base.h"
 #include "timeseries_qwt.h"
 
+#include "plotcurve.h"
+#include "incremental_painter.h"
 #include "plotmagnifier.h"
 #include "plotzoomer.h"
 #include "plotlegend.h"
@@ -23,6 +25,7 @@
 #include "qwt_plot_legenditem.h"
 #include "qwt_plot_marker.h"
 #include "qwt_plot_layout.h"
+#include "qwt_painter.h"
 #include "qwt_scale_engine.h"
 #include "qwt_scale_map.h"
 #include "qwt_scale_draw.h"
@@ -37,6 +40,8 @@
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QHBoxLayout>
+#include <QtConcurrent>
+#include <QElapsedTimer>
 
 #include "plotpanner.h"
 
@@ -144,6 +149,26 @@ public:
 
   bool zoom_enabled = true;
 
+  IncrementalPainter incremental_painter;
+  // replot() was called, but the canvas was not painted yet
+  bool replot_pending = false;
+  // allowIncrementalPaint() was called since the last replot()
+  bool incremental_requested = false;
+  double level_of_detail = 1.0;
+  qint64 paint_nsecs = 0;
+
+  void drawCanvas(QPainter* painter) override
+  {
+    QElapsedTimer timer;
+    timer.start();
+    replot_pending = false;
+    if (!incremental_painter.paint(*this, painter))
+    {
+      QwtPlot::drawCanvas(painter);
+    }
+    paint_nsecs += timer.nsecsElapsed();
+  }
+
   void dragEnterEvent(QDragEnterEvent* event) override
   {
     event_callback(event);
@@ -400,7 +425,8 @@ PlotWidgetBase::CurveInfo* PlotWidgetBase::addCurve(const std::string& name,
     return nullptr;  // TODO FIXME
   }
 
-  auto curve = new QwtPlotCurve(qname);
+  auto curve = new PlotCurve(qname);
+  curve->setLevelOfDetail(p->level_of_detail);
   try
   {
     QwtSeriesWrapper* plot_qwt = nullptr;
@@ -783,9 +809,110 @@ void PlotWidgetBase::replot()
   {
     p->zoomer->setZoomBase(false);
   }
+  // the data might have changed since the last call of prepareCurves()
+  for (auto& it : curveList())
+  {
+    if (auto curve = dynamic_cast<PlotCurve*>(it.curve))
+    {
+      curve->resetPreparedLines();
+    }
+  }
+  // a replot that was not requested as incremental (zoom, new curves, etc.)
+  // disables the incremental paint, unless it is coalesced with one that was.
+  if (p->incremental_requested)
+  {
+    p->incremental_painter.allowNextFrame();
+  }
+  else if (!p->replot_pending)
+  {
+    p->incremental_painter.allowNextFrame(false);
+  }
+  p->incremental_requested = false;
+  p->replot_pending = true;
   qwtPlot()->replot();
 }
 
+void PlotWidgetBase::allowIncrementalPaint()
+{
+  p->incremental_requested = true;
+}
+
+void PlotWidgetBase::setLevelOfDetail(double lod)
+{
+  p->level_of_detail = lod;
+  for (auto& it : curveList())
+  {
+    if (auto curve = dynamic_cast<PlotCurve*>(it.curve))
+    {
+      curve->setLevelOfDetail(lod);
+    }
+  }
+}
+
+double PlotWidgetBase::levelOfDetail() const
+{
+  return p->level_of_detail;
+}
+
+qint64 PlotWidgetBase::takePaintTime()
+{
+  return std::exchange(p->paint_nsecs, 0);
+}
+
+void PlotWidgetBase::prepareCurves(const std::vector<PlotWidgetBase*>& widgets)
+{
+  struct Job
+  {
+    PlotCurve* curve;
+    QwtScaleMap x_map;
+    QwtScaleMap y_map;
+    QRectF canvas_rect;
+    double pen_width;
+  };
+
+  // reading a series updates its caches, therefore all the curves that
+  // display the same series are prepared sequentially, by the same thread.
+  std::map<const PlotDataXY*, std::vector<Job>> jobs_per_series;
+
+  for (auto widget : widgets)
+  {
+    // in the incremental paint, the curves are drawn only in a small region
+    if (!widget->isVisible() || !widget->p->replot_pending ||
+        widget->p->incremental_painter.canScroll(*widget->p))
+    {
+      continue;
+    }
+    const QwtPlot* plot = widget->qwtPlot();
+    const QRectF canvas_rect = plot->canvas()->contentsRect();
+
+    for (auto& it : widget->curveList())
+    {
+      auto curve = dynamic_cast<PlotCurve*>(it.curve);
+      if (!curve || !curve->isVisible() || !curve->canPrepareLines())
+      {
+        continue;
+      }
+      auto series = static_cast<QwtSeriesWrapper*>(curve->data());
+      jobs_per_series[series->plotData()].push_back(
+          { curve, plot->canvasMap(curve->xAxis()), plot->canvasMap(curve->yAxis()),
+            canvas_rect, QwtPainter::effectivePenWidth(curve->pen()) });
+    }
+  }
+
+  std::vector<std::vector<Job>*> tasks;
+  for (auto& it : jobs_per_series)
+  {
+    tasks.push_back(&it.second);
+  }
+  // the calling thread takes part in the work too
+  QtConcurrent::blockingMap(tasks, [](std::vector<Job>* jobs) {
+    for (auto& job : *jobs)
+    {
+      job.curve->prepareLines(job.x_map, job.y_map, job.canvas_rect, job.pen_width);
+    }
+  });
+}
+
 void PlotWidgetBase::removeAllCurves()
 {
   for (auto& it : curveList())
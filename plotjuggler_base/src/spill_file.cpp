@@ -0,0 +1,116 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ */
+
+#include "PlotJuggler/spill_file.h"
+#include <QTemporaryFile>
+#include <QDir>
+#include <cstring>
+
+namespace PJ
+{
+struct SpillFile::Segment
+{
+  // each segment has its own file, that is mapped only once: on some
+  // platforms a file can't be mapped again after it is resized.
+  QTemporaryFile file;
+  uchar* data = nullptr;
+  size_t used = 0;
+  size_t count = 0;  // streams not released yet
+};
+
+SpillFile& SpillFile::global()
+{
+  static SpillFile spill_file;
+  return spill_file;
+}
+
+SpillFile::SpillFile() = default;
+
+SpillFile::~SpillFile() = default;
+
+SpillFile::Stream SpillFile::store(const uint64_t* words, size_t count)
+{
+  const size_t bytes = count * sizeof(uint64_t);
+  if (!_enabled || bytes == 0 || bytes > SEGMENT_SIZE)
+  {
+    return {};
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if (_current == NO_SEGMENT || _segments[_current]->used + bytes > SEGMENT_SIZE)
+  {
+    if (!addSegment())
+    {
+      return {};
+    }
+  }
+  auto& segment = *_segments[_current];
+  auto* dst = reinterpret_cast<uint64_t*>(segment.data + segment.used);
+  std::memcpy(dst, words, bytes);
+  segment.used += bytes;
+  segment.count++;
+  _stored_bytes += bytes;
+
+  const size_t segment_id = _current;
+  return Stream(dst, [this, segment_id, bytes](const uint64_t*) {
+    release(segment_id, bytes);
+  });
+}
+
+size_t SpillFile::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _stored_bytes;
+}
+
+bool SpillFile::addSegment()
+{
+  auto segment = std::make_unique<Segment>();
+  segment->file.setFileTemplate(QDir::tempPath() + "/plotjuggler_spill_XXXXXX");
+  // resize() makes a sparse file: disk space is used only by the data written
+  if (!segment->file.open() || !segment->file.resize(SEGMENT_SIZE))
+  {
+    return false;
+  }
+  segment->data = segment->file.map(0, SEGMENT_SIZE);
+  if (!segment->data)
+  {
+    return false;
+  }
+
+  // the previous segment can be deleted, if it was already emptied
+  if (_current != NO_SEGMENT && _segments[_current]->count == 0)
+  {
+    _segments[_current].reset();
+  }
+  _segments.push_back(std::move(segment));
+  _current = _segments.size() - 1;
+  return true;
+}
+
+void SpillFile::release(size_t segment_id, size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& segment = _segments[segment_id];
+  segment->count--;
+  _stored_bytes -= bytes;
+  if (segment->count > 0)
+  {
+    return;
+  }
+  if (segment_id == _current)
+  {
+    // keep the current segment, it can be reused from the beginning
+    segment->used = 0;
+  }
+  else
+  {
+    // unmapped and deleted by QTemporaryFile
+    segment.reset();
+  }
+}
+
+}  // namespace PJ
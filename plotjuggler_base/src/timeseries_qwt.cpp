@@ -5,6 +5,7 @@
  */
 
 #include "timeseries_qwt.h"
+#include <algorithm>
 #include <limits>
 #include <stdexcept>
 #include <QMessageBox>
@@ -44,16 +45,8 @@ RangeOpt QwtTimeseries::getVisualizationRangeY(Range range_X)
     return _ts_data->rangeY();
   }
 
-  double min_y = (std::numeric_limits<double>::max());
-  double max_y = (std::numeric_limits<double>::lowest());
-
-  for (size_t i = first_index; i < last_index; i++)
-  {
-    const double Y = sample(i).y();
-    min_y = std::min(min_y, Y);
-    max_y = std::max(max_y, Y);
-  }
-  return Range{ min_y, max_y };
+  // O(log n) thanks to the min/max summaries of the series
+  return _ts_data->rangeY(first_index, last_index + 1);
 }
 
 std::optional<QPointF> QwtTimeseries::sampleFromTime(double t)
@@ -67,6 +60,79 @@ std::optional<QPointF> QwtTimeseries::sampleFromTime(double t)
   return QPointF(p.x, p.y);
 }
 
+bool QwtTimeseries::decimate(Range range_x, size_t columns,
+                             std::vector<QPointF>& points) const
+{
+  points.clear();
+  if (!_ts_data || columns == 0)
+  {
+    return false;
+  }
+  const auto& data = *_ts_data;
+  if (data.size() == 0)
+  {
+    return true;
+  }
+  const auto& storage = data.columns();
+
+  auto addPoint = [&](size_t index) {
+    points.emplace_back(storage.x(index) - _time_offset, storage.y(index));
+  };
+
+  // include the samples just outside the visible range, to draw the
+  // segments that cross its borders
+  size_t first = storage.lowerBound(range_x.min + _time_offset);
+  size_t last = storage.upperBound(range_x.max + _time_offset);
+  first = (first > 0) ? first - 1 : 0;
+  last = std::min(last + 1, data.size());
+
+  if (last - first <= 4 * columns)
+  {
+    for (size_t i = first; i < last; i++)
+    {
+      addPoint(i);
+    }
+    return true;
+  }
+
+  const double step = (range_x.max - range_x.min) / double(columns);
+  addPoint(first);
+  size_t index = first + 1;
+
+  for (size_t col = 1; col <= columns && index < last - 1; col++)
+  {
+    // samples in [index, next) belong to this column
+    size_t next = last - 1;
+    if (col < columns)
+    {
+      const double column_end = range_x.min + _time_offset + step * double(col);
+      next = std::clamp(storage.lowerBound(column_end), index, last - 1);
+    }
+    if (next - index <= 4)
+    {
+      for (size_t i = index; i < next; i++)
+      {
+        addPoint(i);
+      }
+    }
+    else
+    {
+      // min and max come from the pyramid of the series, in O(log n).
+      // We don't know their order, but they are drawn in the same pixel column
+      const auto range_y = data.rangeY(index, next).value();
+      const double mid_x =
+          0.5 * (storage.x(index) + storage.x(next - 1)) - _time_offset;
+      addPoint(index);
+      points.emplace_back(mid_x, range_y.min);
+      points.emplace_back(mid_x, range_y.max);
+      addPoint(next - 1);
+    }
+    index = next;
+  }
+  addPoint(last - 1);
+  return true;
+}
+
 TransformedTimeseries::TransformedTimeseries(const PlotData* source_data)
   : QwtTimeseries(&_dst_data)
   , _dst_data(source_data->plotName(), {})
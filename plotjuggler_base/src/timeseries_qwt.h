@@ -7,6 +7,7 @@
 #ifndef TIMESERIES_QWT_H
 #define TIMESERIES_QWT_H
 
+#include <vector>
 #include "qwt_series_data.h"
 #include "PlotJuggler/plotdata.h"
 #include "PlotJuggler/transform_function.h"
@@ -39,6 +40,13 @@ public:
   virtual void updateCache(bool reset_old_data)
   {
   }
+
+  /// Modification epoch of the series read by updateCache(). If it didn't
+  /// change, the cache is still up to date. See PlotDataBase::modificationEpoch()
+  virtual uint64_t sourceEpoch() const
+  {
+    return _data ? _data->modificationEpoch() : 0;
+  }
 };
 
 class QwtTimeseries : public QwtSeriesWrapper
@@ -54,12 +62,27 @@ public:
 
   void setTimeOffset(double offset);
 
+  double timeOffset() const
+  {
+    return _time_offset;
+  }
+
   virtual RangeOpt getVisualizationRangeX() override;
 
   virtual RangeOpt getVisualizationRangeY(Range range_X) override;
 
   virtual std::optional<QPointF> sampleFromTime(double t);
 
+  /**
+   * @brief Level of detail used for rendering (M4 decimation): for each one of
+   * the "columns" intervals in which range_x is divided, keep only the first,
+   * minimum, maximum and last sample.
+   * The cost depends on the number of columns, not on the size of the series.
+   *
+   * @return false if the decimation is not supported by this series.
+   */
+  bool decimate(Range range_x, size_t columns, std::vector<QPointF>& points) const;
+
   void updateCache(bool) override
   {
   }
@@ -82,6 +105,11 @@ public:
 
   virtual void updateCache(bool reset_old_data) override;
 
+  uint64_t sourceEpoch() const override
+  {
+    return _src_data->modificationEpoch();
+  }
+
   QString transformName();
 
   QString alias() const;
@@ -486,6 +486,18 @@ bool DataLoadCSV::readDataFromFile(FileLoadInfo* info, PlotDataMapRef& plot_data
     string_vector.push_back(&(str_it->second));
   }
 
+  // numeric values are buffered and pushed to the series in batches
+  const size_t BATCH_SIZE = 1024;
+  std::vector<std::vector<double>> batch_x(column_names.size());
+  std::vector<std::vector<double>> batch_y(column_names.size());
+
+  auto flushBatch = [&](unsigned i) {
+    plots_vector[i]->pushBackBatch(batch_x[i].data(), batch_y[i].data(),
+                                   batch_x[i].size());
+    batch_x[i].clear();
+    batch_y[i].clear();
+  };
+
   //-----------------
   double prev_time = std::numeric_limits<double>::lowest();
   bool parse_date_format = _ui->checkBoxDateFormat->isChecked();
@@ -716,7 +728,12 @@ bool DataLoadCSV::readDataFromFile(FileLoadInfo* info, PlotDataMapRef& plot_data
       double y = ParseNumber(str, is_number);
       if (is_number)
       {
-        plots_vector[i]->pushBack({ timestamp, y });
+        batch_x[i].push_back(timestamp);
+        batch_y[i].push_back(y);
+        if (batch_x[i].size() == BATCH_SIZE)
+        {
+          flushBatch(i);
+        }
       }
       else
       {
@@ -736,6 +753,11 @@ bool DataLoadCSV::readDataFromFile(FileLoadInfo* info, PlotDataMapRef& plot_data
     }
   }
 
+  for (unsigned i = 0; i < column_names.size(); i++)
+  {
+    flushBatch(i);
+  }
+
   if (interrupted)
   {
     progress_dialog.cancel();
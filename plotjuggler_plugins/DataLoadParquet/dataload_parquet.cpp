@@ -158,11 +158,29 @@ bool DataLoadParquet::readDataFromFile(FileLoadInfo* info, PlotDataMapRef& plot_
 
   parquet::StreamReader os{ std::move(parquet_reader_) };
 
-  std::vector<double> row_values(num_columns, 0.0);
+  // rows are buffered and pushed to the series in batches: the values of a
+  // column are read with a stride equal to num_columns.
+  const size_t BATCH_ROWS = 1024;
+  std::vector<double> batch_values(BATCH_ROWS * num_columns, 0.0);
+  std::vector<double> batch_timestamps(BATCH_ROWS);
+  size_t batch_size = 0;
+
+  auto flushBatch = [&]() {
+    for (size_t col = 0; col < num_columns; col++)
+    {
+      if (valid_column[col])
+      {
+        series[col]->pushBackBatch(batch_timestamps.data(), &batch_values[col], batch_size,
+                                   1, num_columns);
+      }
+    }
+    batch_size = 0;
+  };
 
   int row = 0;
   while (!os.eof())
   {
+    double* row_values = &batch_values[batch_size * num_columns];
     // extract an entire row
     for (size_t col = 0; col < num_columns; col++)
     {
@@ -274,19 +292,13 @@ bool DataLoadParquet::readDataFromFile(FileLoadInfo* info, PlotDataMapRef& plot_
     double timestamp = timestamp_column >= 0 ? row_values[timestamp_column] : row;
     row++;
 
-    for (size_t col = 0; col < num_columns; col++)
+    batch_timestamps[batch_size++] = timestamp;
+    if (batch_size == BATCH_ROWS)
     {
-      if (!valid_column[col])
-      {
-        continue;
-      }
-
-      if (valid_column[col])
-      {
-        series[col]->pushBack({ timestamp, row_values[col] });
-      }
+      flushBatch();
     }
   }
+  flushBatch();
   return true;
 }
 
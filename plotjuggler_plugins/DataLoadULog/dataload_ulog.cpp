@@ -46,24 +46,27 @@ bool DataLoadULog::readDataFromFile(FileLoadInfo* fileload_info,
 
   const auto& timeseries_map = parser.getTimeseriesMap();
   auto min_msg_time = std::numeric_limits<double>::max();
+  std::vector<double> msg_times;
   for (const auto& it : timeseries_map)
   {
     const std::string& sucsctiption_name = it.first;
     const ULogParser::Timeseries& timeseries = it.second;
 
+    // the timestamps are shared by all the fields of the subscription
+    msg_times.resize(timeseries.timestamps.size());
+    for (size_t i = 0; i < timeseries.timestamps.size(); i++)
+    {
+      msg_times[i] = static_cast<double>(timeseries.timestamps[i]) * 0.000001;
+      min_msg_time = std::min(min_msg_time, msg_times[i]);
+    }
+
     for (const auto& data : timeseries.data)
     {
       std::string series_name = sucsctiption_name + data.first;
 
       auto series = plot_data.addNumeric(series_name);
-
-      for (size_t i = 0; i < data.second.size(); i++)
-      {
-        double msg_time = static_cast<double>(timeseries.timestamps[i]) * 0.000001;
-        min_msg_time = std::min(min_msg_time, msg_time);
-        PlotData::Point point(msg_time, data.second[i]);
-        series->second.pushBack(point);
-      }
+      const size_t count = std::min(data.second.size(), msg_times.size());
+      series->second.pushBackBatch(msg_times.data(), data.second.data(), count);
     }
   }
 
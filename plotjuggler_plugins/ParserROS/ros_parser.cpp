@@ -90,6 +90,25 @@ ParserROS::ParserROS(const std::string& topic_name, const std::string& type_name
   }
 }
 
+// The fields of the messages of a topic are usually the same, in the same order,
+// unless they contain arrays of variable size.
+template <typename Handle>
+Handle& ParserROS::cachedHandle(std::vector<CachedSeries<Handle>>& cache, size_t index,
+                                const RosMsgParser::FieldsVector& key)
+{
+  if (index >= cache.size())
+  {
+    cache.resize(index + 1);
+  }
+  auto& cached = cache[index];
+  if (!(cached.key.fields == key.fields && cached.key.index_array == key.index_array))
+  {
+    cached.key = key;
+    cached.handle = {};
+  }
+  return cached.handle;
+}
+
 bool ParserROS::parseMessage(const PJ::MessageRef serialized_msg, double& timestamp)
 {
   if (_customized_parser)
@@ -120,17 +139,26 @@ bool ParserROS::parseMessage(const PJ::MessageRef serialized_msg, double& timest
 
   std::string series_name;
 
-  for (const auto& [key, str] : _flat_msg.name)
+  for (size_t i = 0; i < _flat_msg.name.size(); i++)
   {
-    key.toStr(series_name);
-    StringSeries& data = getStringSeries(series_name);
-    data.pushBack({ timestamp, str });
+    const auto& key = _flat_msg.name[i].first;
+    auto& handle = cachedHandle(_string_cache, i, key);
+    StringSeries& data = getStringSeries(handle, [&]() -> const std::string& {
+      key.toStr(series_name);
+      return series_name;
+    });
+    data.pushBack({ timestamp, _flat_msg.name[i].second });
   }
 
-  for (const auto& [key, value] : _flat_msg.value)
+  for (size_t i = 0; i < _flat_msg.value.size(); i++)
   {
-    key.toStr(series_name);
-    PlotData& data = getSeries(series_name);
+    const auto& key = _flat_msg.value[i].first;
+    const auto& value = _flat_msg.value[i].second;
+    auto& handle = cachedHandle(_numeric_cache, i, key);
+    PlotData& data = getSeries(handle, [&]() -> const std::string& {
+      key.toStr(series_name);
+      return series_name;
+    });
 
     if (!_strict_truncation_check)
     {
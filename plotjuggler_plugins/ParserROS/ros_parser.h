@@ -64,6 +64,20 @@ protected:
 
   std::function<void(const std::string& prefix, double&)> _customized_parser;
 
+  // series of the fields of the previous message, in the same order of _flat_msg
+  template <typename Handle>
+  struct CachedSeries
+  {
+    RosMsgParser::FieldsVector key;
+    Handle handle;
+  };
+  std::vector<CachedSeries<PJ::NumericHandle>> _numeric_cache;
+  std::vector<CachedSeries<PJ::StringSeriesHandle>> _string_cache;
+
+  template <typename Handle>
+  Handle& cachedHandle(std::vector<CachedSeries<Handle>>& cache, size_t index,
+                       const RosMsgParser::FieldsVector& key);
+
   bool _has_header = false;
   bool _strict_truncation_check = true;
 };
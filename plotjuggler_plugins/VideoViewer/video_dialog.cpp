@@ -56,7 +56,8 @@ void ImageLabel::paintEvent(QPaintEvent* event)
   painter.drawPixmap(corner, scaled_pix);
 }
 
-VideoDialog::VideoDialog(QWidget* parent) : QDialog(parent), ui(new Ui::VideoDialog)
+VideoDialog::VideoDialog(QWidget* parent)
+  : QDialog(parent), ui(new Ui::VideoDialog), _compressed_frames("video_frames", {})
 {
   using namespace QtAV;
 
@@ -191,9 +192,10 @@ void VideoDialog::on_timeSlider_valueChanged(int num)
     num = std::max(0, num);
     num = std::min(int(_compressed_frames.size() - 1), num);
 
-    auto& frame = _compressed_frames[num];
-    void* data = qoi_decode(frame.data, frame.length, &frame.info, 3);
-    QImage image(static_cast<uchar*>(data), frame.info.width, frame.info.height,
+    const PJ::BlobRef frame = _compressed_frames.at(num).y;
+    qoi_desc info;
+    void* data = qoi_decode(frame.data, int(frame.size), &info, 3);
+    QImage image(static_cast<uchar*>(data), info.width, info.height,
                  QImage::Format_RGB888);
 
     // qDebug() << "ratio: " << double(3*frame.info.width*frame.info.height) /
@@ -317,16 +319,16 @@ void VideoDialog::on_decodeButton_clicked()
 
       QImage image = frame.toImage(QImage::Format_RGB888);
 
-      CompressedFrame compressed_frame;
-      compressed_frame.info.width = frame.width();
-      compressed_frame.info.height = frame.height();
-      compressed_frame.info.channels = 3;
-      compressed_frame.info.colorspace = QOI_LINEAR;
-      compressed_frame.data =
-          qoi_encode(image.bits(), &compressed_frame.info, &compressed_frame.length);
-
-      //      _frames.push_back( std::move(image) );
-      _compressed_frames.push_back(std::move(compressed_frame));
+      qoi_desc info;
+      info.width = frame.width();
+      info.height = frame.height();
+      info.channels = 3;
+      info.colorspace = QOI_LINEAR;
+      int length = 0;
+      void* encoded = qoi_encode(image.bits(), &info, &length);
+      // the payload is copied into the pages of the series
+      _compressed_frames.pushBack({ double(count), PJ::BlobRef(encoded, length) });
+      free(encoded);
 
       if (++count % 10 == 0)
       {